@@ -0,0 +1,95 @@
+// Audio engine: every clip is rendered once into an AudioBuffer at load and
+// played through a fixed pool of voices (a gain node each, stealing the
+// oldest when all are busy), so a sound costs one buffer source and no
+// decoding. The thrust rumble is a single AudioWorklet node whose level
+// follows the button. The context starts suspended until the first input.
+(function(root){
+  const VOICES=8;
+
+  // clips are synthesized since the game ships no audio files; a clip may
+  // also be a URL, which is fetched and decoded once like the rest
+  const CLIPS={
+    puff:{seconds:0.12,fn:(t,r)=>(r()*2-1)*Math.exp(-t*40)*0.5},
+    heart:{seconds:0.15,fn:t=>Math.sin(2*Math.PI*(880*t+1800*t*t))*Math.exp(-t*20)*0.25},
+    victory:{seconds:1.2,fn:t=>{
+      const f=[523.25,659.25,783.99,1046.5][Math.min(3,Math.floor(t/0.2))];
+      return Math.sin(2*Math.PI*f*t)*Math.exp(-(t%0.2)*6)*0.3*(t<1?1:1-(t-1)/0.2);
+    }},
+    crash:{seconds:0.6,fn:(t,r)=>(r()*2-1)*Math.exp(-t*6)*0.6},
+  };
+
+  function createAudio(){
+    const AC=root.AudioContext||root.webkitAudioContext;
+    if(!AC) return null;
+    const ctx=new AC({latencyHint:'interactive'});
+    const buffers={},voices=[];
+    const a={ctx,ready:false,latencyMs:0,onLatency:null};
+
+    let seed=1;
+    const r=()=>(seed=seed*48271%2147483647)/2147483647;
+    Object.keys(CLIPS).forEach(name=>{
+      const c=CLIPS[name];
+      if(typeof c==='string'){
+        fetch(c).then(res=>res.arrayBuffer()).then(b=>ctx.decodeAudioData(b))
+          .then(b=>{buffers[name]=b;}).catch(e=>console.warn('audio '+name+': '+e.message));
+        return;
+      }
+      const b=ctx.createBuffer(1,Math.ceil(c.seconds*ctx.sampleRate),ctx.sampleRate),d=b.getChannelData(0);
+      for(let i=0;i<d.length;i++) d[i]=c.fn(i/ctx.sampleRate,r);
+      buffers[name]=b;
+    });
+    for(let i=0;i<VOICES;i++){
+      const gain=ctx.createGain();
+      gain.connect(ctx.destination);
+      voices.push({gain,source:null,started:0});
+    }
+
+    let thrust=null;
+    if(ctx.audioWorklet){
+      ctx.audioWorklet.addModule('thrust-worklet.js').then(()=>{
+        thrust=new AudioWorkletNode(ctx,'thrust',{outputChannelCount:[1]});
+        thrust.connect(ctx.destination);
+      }).catch(e=>console.warn('audio thrust: '+e.message));
+    }
+
+    // the context may only start inside a user gesture
+    a.unlock=()=>{
+      if(ctx.state!=='running') ctx.resume().then(()=>{a.ready=true;});
+      else a.ready=true;
+    };
+    // a sound started while the context is still resuming (the first press)
+    // plays once it runs
+    a.play=(name,volume=1)=>{
+      const b=buffers[name];
+      if(!b||ctx.state==='closed') return;
+      let v=voices[0];
+      for(const x of voices){
+        if(!x.source){v=x; break;}
+        if(x.started<v.started) v=x;
+      }
+      if(v.source){v.source.onended=null; v.source.stop();}
+      const s=ctx.createBufferSource();
+      s.buffer=b; s.connect(v.gain);
+      s.onended=()=>{if(v.source===s) v.source=null;};
+      v.gain.gain.value=volume; v.source=s; v.started=ctx.currentTime;
+      s.start();
+    };
+    a.setThrust=on=>{
+      if(thrust) thrust.parameters.get('level').setTargetAtTime(on?1:0,ctx.currentTime,0.02);
+    };
+    // input-to-audible latency: from the input event to when a sound started
+    // now reaches the speakers. getOutputTimestamp() pairs the frame the
+    // device is playing with the performance clock, so mapping the next
+    // render quantum through it includes the output latency.
+    a.measure=eventTime=>{
+      if(ctx.state!=='running'||!ctx.getOutputTimestamp) return;
+      const ts=ctx.getOutputTimestamp(),start=ctx.currentTime+128/ctx.sampleRate;
+      const audible=ts.performanceTime+(start-ts.contextTime)*1000;
+      a.latencyMs=audible-eventTime;
+      if(a.onLatency) a.onLatency(a.latencyMs);
+    };
+    return a;
+  }
+
+  root.MAFAudio={createAudio};
+})(this);
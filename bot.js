@@ -0,0 +1,77 @@
+// Autopilot: a beam search over press/release sequences on forked worlds.
+//
+// Each think() forks the live world, then expands the beam one segment
+// (SEGMENT steps of holding or not holding) per level for DEPTH levels,
+// keeping the BEAM best candidates. A candidate scores its smallest
+// clearance to any obstacle, and a collision scores below every clean
+// path, later collisions less badly. All forked worlds come from a pool
+// built once, and the search stops at the per-call budget, acting on the
+// best complete level it reached.
+(function(root,factory){
+  if(typeof module==='object'&&module.exports) module.exports=factory(require('./sim.js'));
+  else root.MAFBot=factory(root.MAFSim);
+})(this,function(Sim){
+  const SEGMENT=60,DEPTH=8,BEAM=12,CLEAR_CAP=200;
+  const B=Sim.PLANE_BOX;
+
+  // distance between the plane box and the nearest obstacle, 0 on overlap
+  function clearance(w){
+    const p=w.plane,l=p.x+B.left,r=p.x+B.right,t=p.y+B.top,b=p.y+B.bottom;
+    let best=CLEAR_CAP;
+    for(let i=0;i<w.n;i++){
+      const dx=Math.max(w.ox[i]-r,l-(w.ox[i]+w.ow[i]),0),dy=Math.max(w.oy[i]-b,t-(w.oy[i]+w.oh[i]),0);
+      if(!dx&&!dy) return 0;
+      best=Math.min(best,Math.hypot(dx,dy));
+    }
+    return best;
+  }
+
+  function createBot(opts){
+    const o=Object.assign({segment:SEGMENT,depth:DEPTH,beam:BEAM,budgetMs:4,
+      now:()=>performance.now()},opts);
+    const node=()=>({world:Sim.createWorld(0),first:-1,score:0,hit:0,t:0,rank:0});
+    const beam=[],next=[];
+    for(let i=0;i<o.beam;i++) beam.push(node());
+    for(let i=0;i<o.beam*2;i++) next.push(node());
+    const stats={levels:0,clearance:CLEAR_CAP};
+
+    // fork src into dst and fly one more segment, folding clearance into the score
+    function expand(dst,src,hold){
+      Sim.copyWorld(dst.world,src.world);
+      dst.first=src.first<0?hold:src.first;
+      dst.score=src.score; dst.hit=src.hit; dst.t=src.t;
+      for(let i=0;i<o.segment&&!dst.hit;i++){
+        Sim.stepWorld(dst.world,hold,Sim.STEP);
+        const c=clearance(dst.world);
+        dst.t++;
+        if(!c) dst.hit=dst.t;
+        dst.score=Math.min(dst.score,c);
+      }
+      dst.rank=dst.hit?dst.hit-1e6:dst.score-Math.abs(dst.world.plane.y-Sim.FIELD_H/2)*0.01;
+    }
+
+    function think(world){
+      const deadline=o.now()+o.budgetMs,root=beam[0];
+      Sim.copyWorld(root.world,world);
+      root.first=-1; root.score=CLEAR_CAP; root.hit=0; root.t=0;
+      let size=1;
+      stats.levels=0;
+      for(let level=0;level<o.depth;level++){
+        let n=0;
+        for(let i=0;i<size;i++) for(let a=0;a<2;a++) expand(next[n++],beam[i],a);
+        for(let i=n;i<next.length;i++) next[i].rank=-Infinity;
+        next.sort((a,b)=>b.rank-a.rank);
+        // swap the survivors into the beam; worlds are never reallocated
+        size=Math.min(o.beam,n);
+        for(let i=0;i<size;i++){const t=beam[i]; beam[i]=next[i]; next[i]=t;}
+        stats.levels++;
+        if(o.now()>deadline) break;
+      }
+      stats.clearance=beam[0].hit?0:beam[0].score;
+      return beam[0].first===1;
+    }
+    return {think,stats};
+  }
+
+  return {createBot,clearance};
+});
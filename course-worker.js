@@ -0,0 +1,118 @@
+// Streams a binary course file (.mafc) and decodes it chunk by chunk.
+//
+// Layout, little endian:
+//   header  16 bytes  "MAFC", u16 version, u16 record size, u16 chunk km,
+//                     u16 reserved, u32 total km
+//   chunk    8 bytes  u32 chunk index, u16 record count, u16 reserved
+//   record  12 bytes  u16 km offset in chunk (1/100 km), u16 top y and
+//                     u16 height (fractions of the playfield, /65535),
+//                     u16 speed px/s, u8 kind, u8 flags, u16 param
+//
+// Chunks are only decoded, and the reader only pulled, until they reach
+// LOOKAHEAD_KM past the km the game last reported, so a course of any
+// length streams in constant memory on both sides.
+//
+// One worker serves many game instances (see the pool in game.js): every
+// message carries the id of its stream, and each stream has its own state.
+const MAGIC=0x4346414d,HEADER=16,CHUNK_HEADER=8,RECORD=12,FIELDS=6,LOOKAHEAD_KM=300;
+
+const streams=new Map();
+function createStream(id){
+  return {id,reader:null,pending:new Uint8Array(4096),pendingLen:0,
+    header:null,decodedKm:0,flownKm:0,pulling:false,eof:false,done:false};
+}
+
+function append(s,bytes){
+  if(s.pendingLen+bytes.length>s.pending.length){
+    const grown=new Uint8Array(Math.max(s.pending.length*2,s.pendingLen+bytes.length));
+    grown.set(s.pending.subarray(0,s.pendingLen)); s.pending=grown;
+  }
+  s.pending.set(bytes,s.pendingLen); s.pendingLen+=bytes.length;
+}
+function consume(s,n){
+  s.pending.copyWithin(0,n,s.pendingLen); s.pendingLen-=n;
+}
+
+// decode complete units at the front of the pending bytes, up to the lookahead
+function decode(s){
+  const view=new DataView(s.pending.buffer,0,s.pendingLen);
+  if(!s.header){
+    if(s.pendingLen<HEADER) return;
+    if(view.getUint32(0,true)!==MAGIC) throw new Error('not a course file');
+    s.header={version:view.getUint16(4,true),recordSize:view.getUint16(6,true),
+      chunkKm:view.getUint16(8,true),totalKm:view.getUint32(12,true)};
+    if(s.header.version!==1||s.header.recordSize!==RECORD) throw new Error('unsupported course version');
+    postMessage({id:s.id,type:'header',chunkKm:s.header.chunkKm,totalKm:s.header.totalKm});
+    consume(s,HEADER);
+    return decode(s);
+  }
+  let off=0;
+  while(off+CHUNK_HEADER<=s.pendingLen&&s.decodedKm<s.flownKm+LOOKAHEAD_KM){
+    const index=view.getUint32(off,true),count=view.getUint16(off+4,true),size=CHUNK_HEADER+count*RECORD;
+    if(off+size>s.pendingLen) break;
+    const km0=index*s.header.chunkKm,out=new Float32Array(count*FIELDS);
+    for(let i=0,p=off+CHUNK_HEADER;i<count;i++,p+=RECORD){
+      const o=i*FIELDS;
+      out[o]=km0+view.getUint16(p,true)/100;
+      out[o+1]=view.getUint16(p+2,true)/65535;
+      out[o+2]=view.getUint16(p+4,true)/65535;
+      out[o+3]=view.getUint16(p+6,true);
+      out[o+4]=view.getUint8(p+8);
+      out[o+5]=view.getUint16(p+10,true);
+    }
+    postMessage({id:s.id,type:'chunk',index,km0,records:out},[out.buffer]);
+    s.decodedKm=km0+s.header.chunkKm;
+    off+=size;
+  }
+  if(off) consume(s,off);
+}
+
+async function pull(s){
+  if(s.pulling||s.done) return;
+  s.pulling=true;
+  try{
+    for(;;){
+      decode(s);
+      if(s.header&&s.decodedKm>=s.flownKm+LOOKAHEAD_KM) break;
+      if(s.eof){
+        if(s.pendingLen) throw new Error('truncated course file');
+        s.done=true; postMessage({id:s.id,type:'end'}); break;
+      }
+      const r=await s.reader.read();
+      if(s.done) return; // closed while reading
+      if(r.done) s.eof=true; else append(s,r.value);
+    }
+  }catch(e){
+    s.done=true; s.reader.cancel().catch(()=>{});
+    postMessage({id:s.id,type:'error',message:e.message});
+  }
+  s.pulling=false;
+}
+
+onmessage=async e=>{
+  const m=e.data;
+  if(m.type==='open'){
+    const s=createStream(m.id);
+    streams.set(m.id,s);
+    try{
+      const res=await fetch(m.url);
+      if(!res.ok) throw new Error(`HTTP ${res.status}`);
+      s.reader=res.body.getReader();
+    }catch(err){
+      s.done=true; postMessage({id:s.id,type:'error',message:err.message}); return;
+    }
+    if(s.done) s.reader.cancel().catch(()=>{}); // closed while opening
+    else pull(s);
+  }else if(m.type==='km'){
+    const s=streams.get(m.id);
+    if(!s) return;
+    s.flownKm=m.km;
+    if(s.reader) pull(s);
+  }else if(m.type==='close'){
+    const s=streams.get(m.id);
+    if(!s) return;
+    streams.delete(m.id);
+    if(s.reader&&!s.done) s.reader.cancel().catch(()=>{});
+    s.done=true;
+  }
+};
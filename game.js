@@ -0,0 +1,1222 @@
+// The game as an instantiable engine: MAFGame.create(canvas,opts) starts one
+// instance on a canvas and returns a handle to it. index.html runs a single
+// interactive instance; wall.html runs several in attract mode. Whatever
+// does not depend on one run is shared by every instance on the page:
+//   scheduler  one requestAnimationFrame loop ticking all instances, by
+//              visibility and frame budget (see tick())
+//   assets     decoded images, the collision masks and the text bitmaps
+//   workers    worker pool; course-worker.js multiplexes streams from
+//              every instance over a few shared workers
+// create() options: params (URLSearchParams, default the page's query),
+// hud ({km,timer,net,prof} elements), input (false: no listeners),
+// audio (false: silent), botBudgetMs (autopilot think budget per tick).
+(function(root){
+  const {STEP,FIELD_W,FIELD_H}=MAFSim;
+  const W=()=>FIELD_W,H=()=>FIELD_H;
+
+  // --- shared asset cache ---------------------------------------------------
+  // images are fetched and decoded once per page; text caches are kept per
+  // scale and dropped when no instance draws at that scale any more
+  const assets={images:new Map(),texts:new Map(),
+    image(url){
+      let img=this.images.get(url);
+      if(!img){img=new Image(); img.src=url; this.images.set(url,img);}
+      return img;
+    },
+    // the cache for `scale`, releasing `previous` (one that an earlier call returned)
+    textCache(scale,previous){
+      if(previous){
+        for(const [s,t] of this.texts) if(t.map===previous&&--t.users===0) this.texts.delete(s);
+      }
+      if(!scale) return null;
+      let t=this.texts.get(scale);
+      if(!t) this.texts.set(scale,t={map:new Map(),users:0});
+      t.users++;
+      return t.map;
+    },
+  };
+  const chibiAaron=assets.image("chibi-aaron.png");
+  const hugImg=assets.image("hug.png");
+
+  // the plane around its own origin (geometry in sim.js, which the race
+  // server's masks follow); also rasterized for the collision masks
+  function drawPlaneShape(g,withRider){
+    // Rocket body
+    const H=MAFSim.HULL;
+    g.fillStyle='#eee';
+    g.beginPath();
+    g.moveTo(H[0],H[1]); g.lineTo(H[2],H[3]); g.lineTo(H[4],H[5]); g.closePath();
+    g.fill();
+
+    // Mini Aaron riding on top
+    // sized in field units rather than from the image, so the downscaled
+    // sprite a production build inlines (tools/build.js) draws the same
+    if(withRider&&chibiAaron.complete&&chibiAaron.naturalWidth){
+      const w=MAFSim.RIDER_SIZE,h=w*chibiAaron.height/chibiAaron.width;
+      g.drawImage(chibiAaron,-w/2,-h-MAFSim.RIDER_LIFT,w,h);
+    }
+  }
+
+  // pixel-exact plane collision against row masks of the hull and rider at
+  // the size they are drawn (packing and the hit test are in sim.js, shared
+  // with the race server). Every instance tests against the same masks.
+  const {MASK_FRAMES,MASK_SIZE}=MAFSim;
+  let masks=null;
+  // one rotation frame per resumption, so it can run as a background task
+  function* maskJob(withRider){
+    const c=document.createElement('canvas'),g=c.getContext('2d',{willReadFrequently:true}),S=MASK_SIZE;
+    c.width=c.height=S;
+    const frames=[];
+    for(let f=0;f<MASK_FRAMES;f++){
+      g.setTransform(1,0,0,1,0,0); g.clearRect(0,0,S,S);
+      g.translate(S/2,S/2); g.rotate(MAFSim.maskAngle(f));
+      drawPlaneShape(g,withRider);
+      let data;
+      try{data=g.getImageData(0,0,S,S).data;}
+      catch(e){yield* maskJob(false); return;} // rider image taints the canvas (file://): hull only
+      frames.push(MAFSim.packMask(data,4,3));
+      yield;
+    }
+    masks=frames;
+  }
+  function buildMasks(withRider){
+    const job=maskJob(withRider);
+    while(!job.next().done);
+  }
+
+  // --- worker pool ----------------------------------------------------------
+  // channel(url) looks like a Worker (postMessage, onmessage, terminate) but
+  // is one tagged stream on a shared worker: the least loaded of at most
+  // POOL_SIZE per script. Scripts that keep one job's state in the worker
+  // (recorder-worker.js holds an encoder) ask for an exclusive Worker.
+  const POOL_SIZE=Math.max(1,Math.min(4,((root.navigator&&navigator.hardwareConcurrency)||2)-1));
+  const workers={pools:new Map(),nextId:1,
+    channel(url,{exclusive=false}={}){
+      if(exclusive) return new Worker(url);
+      let pool=this.pools.get(url);
+      if(!pool) this.pools.set(url,pool=[]);
+      let slot=pool.reduce((a,s)=>!a||s.channels.size<a.channels.size?s:a,null);
+      if(!slot||slot.channels.size&&pool.length<POOL_SIZE){
+        slot={worker:new Worker(url),channels:new Map()};
+        slot.worker.onmessage=e=>{
+          const ch=slot.channels.get(e.data.id);
+          if(ch&&ch.onmessage) ch.onmessage(e);
+        };
+        pool.push(slot);
+      }
+      const id=this.nextId++;
+      const ch={onmessage:null,
+        postMessage(m,transfer){slot.worker.postMessage(Object.assign({id},m),transfer||[]);},
+        terminate(){if(slot.channels.delete(id)) slot.worker.postMessage({type:'close',id});}};
+      slot.channels.set(id,ch);
+      return ch;
+    },
+  };
+
+  // --- frame scheduler ------------------------------------------------------
+  // one requestAnimationFrame loop for every instance. An IntersectionObserver
+  // tracks how much of each canvas is on screen: hidden instances are not
+  // ticked at all. When the ticks of one frame take longer than
+  // FRAME_BUDGET_MS on average, the least visible instance is decimated one
+  // step further (ticked every 2nd, 3rd... frame, catching up with several
+  // fixed steps), and decimation is relaxed again, most visible first, once
+  // there is headroom. Interactive instances always run every frame.
+  const FRAME_BUDGET_MS=10,MAX_DECIMATE=8,ADAPT_EVERY=15;
+  // frameMs is the display frame just ended (rAF timestamps), whichever
+  // instances were ticked on it
+  const scheduler={instances:[],frame:0,ms:0,running:false,observer:null,tickAt:0,interval:1000/60,
+    lastTs:0,frameMs:0,
+    add(g){
+      this.instances.push(g);
+      if(root.IntersectionObserver){
+        if(!this.observer) this.observer=new IntersectionObserver(entries=>entries.forEach(e=>{
+          const g=this.instances.find(g=>g.canvas===e.target);
+          if(!g) return;
+          g.visible=e.isIntersecting;
+          g.area=e.intersectionRect.width*e.intersectionRect.height;
+          g.minDecimate=e.intersectionRatio<0.5?2:1;
+          g.decimate=Math.max(g.decimate,g.minDecimate);
+        }),{threshold:[0,0.25,0.5,0.75,1]});
+        this.observer.observe(g.canvas);
+      }
+      if(!this.running){
+        this.running=true; requestAnimationFrame(tick);
+        if(!document.hidden) watchdog.resume();
+      }
+    },
+    remove(g){
+      const i=this.instances.indexOf(g);
+      if(i<0) return;
+      this.instances.splice(i,1);
+      if(this.observer) this.observer.unobserve(g.canvas);
+    },
+  };
+  const priority=g=>g.interactive?Infinity:g.area;
+  function tick(ts){
+    const s=scheduler,t0=performance.now();
+    if(s.tickAt) s.interval=s.interval*0.9+Math.min(100,t0-s.tickAt)*0.1;
+    s.tickAt=t0;
+    s.frameMs=s.lastTs?ts-s.lastTs:0; s.lastTs=ts;
+    s.frame++;
+    s.instances.forEach((g,i)=>{
+      // stagger decimated instances so they do not all land on one frame
+      if(g.visible&&(s.frame+i)%g.decimate===0) g.frame(ts);
+    });
+    const tickMs=performance.now()-t0;
+    s.ms=s.ms*0.9+tickMs*0.1;
+    if(watchdog.active) watchdog.beat(performance.timeOrigin+t0,tickMs);
+    if(s.frame%ADAPT_EVERY===0){
+      const live=s.instances.filter(g=>g.visible&&!g.interactive);
+      if(s.ms>FRAME_BUDGET_MS){
+        const g=live.filter(g=>g.decimate<MAX_DECIMATE).sort((a,b)=>priority(a)-priority(b))[0];
+        if(g) g.decimate++;
+      }else if(s.ms<FRAME_BUDGET_MS*0.5){
+        const g=live.filter(g=>g.decimate>g.minDecimate).sort((a,b)=>priority(b)-priority(a))[0];
+        if(g) g.decimate--;
+      }
+    }
+    if(s.instances.length) requestAnimationFrame(tick);
+    else{s.running=false; s.lastTs=0; watchdog.pause();}
+  }
+
+  // --- background tasks -----------------------------------------------------
+  // tasks.post(name,job,priority) queues deferrable work ('high', 'normal'
+  // or 'low'). A job is a function; if it returns an iterator (a generator
+  // function's result) it is resumed one chunk at a time, so long work
+  // spreads over several slices. Slices run from requestIdleCallback, or
+  // scheduler.postTask at background priority, or a timeout, and end at the
+  // idle deadline or FRAME_MARGIN_MS before the next frame is due, whichever
+  // comes first; a task is only ever preempted between chunks. After a
+  // frame over FRAME_BUDGET_MS only 'high' tasks run, unless another has
+  // waited MAX_WAIT_MS. Queueing delay (post to first chunk) is kept per
+  // task name in a t-digest; report() summarizes it.
+  const PRIORITIES={high:0,normal:1,low:2},FRAME_MARGIN_MS=3,MAX_WAIT_MS=1000,FALLBACK_SLICE_MS=4;
+  const tasks={queues:[[],[],[]],pending:false,byName:new Map(),
+    post(name,job,priority='normal'){
+      const now=performance.now();
+      this.queues[PRIORITIES[priority]].push({name,job,iter:null,started:false,postedAt:now,waitingSince:now});
+      requestSlice();
+    },
+    report(){
+      const out={};
+      this.byName.forEach((r,name)=>{
+        out[name]={runs:r.runs,queuedP50:r.delay.quantile(0.5),queuedP95:r.delay.quantile(0.95),
+          queuedMax:r.delay.max,runMs:r.runMs};
+      });
+      return out;
+    },
+  };
+  function requestSlice(){
+    if(tasks.pending) return;
+    tasks.pending=true;
+    if(root.requestIdleCallback) requestIdleCallback(runSlice,{timeout:MAX_WAIT_MS});
+    else if(root.scheduler&&root.scheduler.postTask) root.scheduler.postTask(()=>runSlice(null),{priority:'background'});
+    else setTimeout(()=>runSlice(null),0);
+  }
+  // the queue whose head runs next
+  function nextQueue(atRisk,now){
+    for(let p=0;p<tasks.queues.length;p++){
+      const q=tasks.queues[p];
+      if(q.length&&(!p||!atRisk||now-q[0].waitingSince>MAX_WAIT_MS)) return q;
+    }
+    return null;
+  }
+  function runSlice(deadline){
+    tasks.pending=false;
+    const s=scheduler,t0=performance.now();
+    let until=t0+(deadline&&!deadline.didTimeout?deadline.timeRemaining():FALLBACK_SLICE_MS);
+    if(s.running) until=Math.min(until,s.tickAt+s.interval-FRAME_MARGIN_MS);
+    const atRisk=s.ms>FRAME_BUDGET_MS;
+    let ran=false;
+    for(let now=t0;;){
+      const q=nextQueue(atRisk,now);
+      if(!q) break;
+      const t=q[0];
+      // past the deadline only a task starved for MAX_WAIT_MS gets a chunk
+      if(now>=until&&now-t.waitingSince<=MAX_WAIT_MS) break;
+      let r=tasks.byName.get(t.name);
+      if(!r) tasks.byName.set(t.name,r={runs:0,runMs:0,delay:MAFStats.createDigest(50)});
+      if(!t.started){t.started=true; r.runs++; r.delay.add(now-t.postedAt);}
+      let done=true;
+      try{
+        if(t.iter) done=t.iter.next().done;
+        else{
+          const v=t.job();
+          if(v&&typeof v.next==='function'){t.iter=v; done=v.next().done;}
+        }
+      }catch(e){console.warn('task '+t.name+': '+e.message);}
+      if(done) q.shift();
+      const end=performance.now();
+      r.runMs+=end-now; t.waitingSince=now=end; ran=true;
+    }
+    if(!tasks.queues.some(q=>q.length)) return;
+    if(ran){requestSlice(); return;}
+    // nothing may run yet (frames over budget, or the next one is due): look
+    // again after a frame, or once the oldest held-back task hits MAX_WAIT_MS,
+    // rather than spinning on idle callbacks
+    const now=performance.now();
+    let wait=s.interval;
+    tasks.queues.forEach(q=>{if(q.length) wait=Math.min(wait,q[0].waitingSince+MAX_WAIT_MS-now);});
+    tasks.pending=true;
+    setTimeout(()=>{tasks.pending=false; requestSlice();},Math.max(1,wait));
+  }
+
+  // --- stall watchdog -------------------------------------------------------
+  // ?watchdog[=ms] starts watchdog-worker.js, which notices when the frame
+  // loop goes quiet for longer than the threshold (STALL_MS by default) and
+  // saves the last WATCH_FRAMES frame records to a crash ring in IndexedDB
+  // while the page is still frozen. A record (WATCH_FIELDS) holds the
+  // tick's phase timings summed over instances, entity counts and queued
+  // background tasks. Records go through a SharedArrayBuffer when the page
+  // is cross-origin isolated, otherwise over a MessageChannel. The worker
+  // is paused while the page stops ticking on purpose: a hidden tab (no
+  // requestAnimationFrame) or a scheduler with no instances left.
+  // watchdog.crashes() resolves to the saved entries, for inspection or
+  // upload; watchdog.clear() empties the ring.
+  const STALL_MS=250,WATCH_FRAMES=120;
+  const WATCH_FIELDS=['at','tickMs','updateMs','renderMs','instances','obstacles','particles',
+    'tasksHigh','tasksNormal','tasksLow'];
+  const watchdog={worker:null,active:false,record:new Float64Array(WATCH_FIELDS.length),
+    shared:null,count:null,port:null,frames:0,paused:false,
+    start(stallMs=STALL_MS){
+      if(this.active||!root.Worker) return;
+      this.active=true;
+      document.addEventListener('visibilitychange',()=>{
+        if(document.hidden) this.pause();
+        else if(scheduler.running) this.resume();
+      });
+      const w=this.open(),msg={type:'start',stallMs,frames:WATCH_FRAMES,fields:WATCH_FIELDS};
+      if(root.crossOriginIsolated&&root.SharedArrayBuffer){
+        msg.shared=new SharedArrayBuffer(8+WATCH_FRAMES*WATCH_FIELDS.length*8);
+        this.count=new Int32Array(msg.shared,0,2); this.shared=new Float64Array(msg.shared,8);
+        w.postMessage(msg);
+      }else{
+        const ch=new MessageChannel();
+        this.port=ch.port1; msg.port=ch.port2;
+        w.postMessage(msg,[ch.port2]);
+      }
+    },
+    pause(){
+      if(!this.active||this.paused) return;
+      this.paused=true; this.worker.postMessage({type:'pause'});
+    },
+    resume(){
+      if(!this.active||!this.paused) return;
+      this.paused=false; this.worker.postMessage({type:'resume'});
+    },
+    open(){
+      if(!this.worker) this.worker=workers.channel('watchdog-worker.js',{exclusive:true});
+      return this.worker;
+    },
+    // the game's share of this tick, from its frame()
+    add(updateMs,renderMs,obstacles,particles){
+      const r=this.record;
+      r[2]+=updateMs; r[3]+=renderMs; r[4]++; r[5]+=obstacles; r[6]+=particles;
+    },
+    // one record per scheduler tick
+    beat(at,tickMs){
+      const r=this.record;
+      r[0]=at; r[1]=tickMs;
+      for(let p=0;p<3;p++) r[7+p]=tasks.queues[p].length;
+      if(this.shared){
+        this.shared.set(r,(this.frames%WATCH_FRAMES)*r.length);
+        Atomics.store(this.count,0,++this.frames);
+      }else this.port.postMessage(r);
+      r.fill(0);
+    },
+    crashes(){
+      const w=this.open();
+      return new Promise(resolve=>{
+        w.onmessage=e=>{if(e.data.type==='crashes') resolve(e.data.list);};
+        w.postMessage({type:'crashes'});
+      });
+    },
+    clear(){this.open().postMessage({type:'clear'});},
+  };
+
+  function create(canvas,opts={}){
+    const params=opts.params||new URLSearchParams(location.search);
+    if(!masks){
+      buildMasks(false);
+      chibiAaron.decode().then(()=>tasks.post('masks',()=>maskJob(true),'low'),()=>{});
+    }
+    const ctx=canvas.getContext('2d');
+    // switches for optional render paths; the harness compares them against
+    // the plain Canvas2D reference (see RENDERERS)
+    const renderOpts={textCache:true};
+
+    // text cache: every distinct string, font and colour is measured and
+    // rasterized once into its own canvas and then only blitted. The caches
+    // live in the shared asset cache, one per scale, so instances drawn at
+    // the same size share their bitmaps; setScale() moves to another one.
+    let textScale=1,textCache=assets.textCache(1);
+    function textBitmap(text,font,color){
+      const key=text+'|'+font+'|'+color;
+      let t=textCache.get(key);
+      if(t) return t;
+      const c=document.createElement('canvas'),g=c.getContext('2d'),pad=2;
+      g.font=font;
+      const m=g.measureText(text),ox=m.actualBoundingBoxLeft+pad,oy=m.actualBoundingBoxAscent+pad;
+      const w=ox+m.actualBoundingBoxRight+pad,h=oy+m.actualBoundingBoxDescent+pad;
+      c.width=Math.max(1,Math.ceil(w*textScale)); c.height=Math.max(1,Math.ceil(h*textScale));
+      g.scale(textScale,textScale);
+      g.font=font; g.fillStyle=color;
+      g.fillText(text,ox,oy);
+      t={canvas:c,w:c.width/textScale,h:c.height/textScale,ox,oy,advance:m.width};
+      textCache.set(key,t);
+      return t;
+    }
+    // same placement as fillText with an alphabetic baseline
+    function drawText(text,font,color,x,y,align){
+      if(!renderOpts.textCache) return drawPlainText(text,font,color,x,y,align);
+      const t=textBitmap(text,font,color);
+      if(align==='center') x-=t.advance/2;
+      ctx.drawImage(t.canvas,x-t.ox,y-t.oy,t.w,t.h);
+    }
+    // uncached, for text that is new every run and would only pile up in the
+    // shared cache
+    function drawPlainText(text,font,color,x,y,align){
+      ctx.font=font; ctx.fillStyle=color; ctx.textAlign=align||'start';
+      ctx.fillText(text,x,y);
+    }
+
+    // the game plays on a fixed FIELD_W x FIELD_H field scaled to the canvas,
+    // so every client simulates the same course whatever its window size.
+    // A ResizeObserver reports the canvas element's size in device pixels
+    // (device-pixel-content-box where supported) and only records it; the
+    // next loop() fits the field into it and reallocates the backing store
+    // once, and only if the fitted size changed, since assigning
+    // canvas.width/height clears and reallocates it. Orientation changes fire
+    // bursts of reports and they all collapse into that one pass.
+    const view={w:0,h:0,boxW:0,boxH:0,dirty:false};
+    let viewScale=1;
+    function observeSize(w,h){
+      if(w===view.boxW&&h===view.boxH) return;
+      view.boxW=w; view.boxH=h; view.dirty=true;
+    }
+    function applyResize(){
+      view.dirty=false;
+      const ratio=FIELD_W/FIELD_H;
+      let w=view.boxW,h=view.boxH;
+      if(w/h>ratio) w=h*ratio; else h=w/ratio;
+      w=Math.max(1,Math.round(w)); h=Math.max(1,Math.round(h));
+      if(w===view.w&&h===view.h) return;
+      view.w=w; view.h=h;
+      canvas.width=w; canvas.height=h;
+      // everything sized from the canvas is rebuilt here, in one place
+      setScale(w/FIELD_W);
+    }
+    function setScale(s){
+      viewScale=textScale=s;
+      textCache=assets.textCache(s,textCache);
+    }
+    const fromWindow=()=>{
+      const dpr=window.devicePixelRatio||1,r=canvas.getBoundingClientRect();
+      observeSize(Math.round(r.width*dpr),Math.round(r.height*dpr));
+    };
+    // every window listener an instance adds goes away with it in destroy()
+    const listeners=new AbortController(),signal=listeners.signal;
+    let ro=null;
+    if(window.ResizeObserver){
+      ro=new ResizeObserver(entries=>{
+        const e=entries[entries.length-1],dpr=window.devicePixelRatio||1;
+        if(e.devicePixelContentBoxSize) observeSize(e.devicePixelContentBoxSize[0].inlineSize,e.devicePixelContentBoxSize[0].blockSize);
+        else observeSize(Math.round(e.contentRect.width*dpr),Math.round(e.contentRect.height*dpr));
+      });
+      try{ro.observe(canvas,{box:'device-pixel-content-box'});}
+      catch(e){ro.observe(canvas);} // older engines reject the box option
+    }else window.addEventListener('resize',fromWindow,{signal});
+    // the element's layout size until the first report arrives
+    fromWindow();
+    applyResize();
+
+    // HUD lines are optional; instances without them update stand-ins
+    const hud=opts.hud||{};
+    const kmEl=hud.km||{},timerEl=hud.timer||{},netEl=hud.net||{},profEl=hud.prof||{};
+    // profiler: per-phase timings of the last PROF_FRAMES frames plus named
+    // metrics; always recorded, shown in the HUD with ?prof
+    const PROF_FRAMES=120;
+    const prof={on:params.has('prof'),frame:0,phases:{update:new Float32Array(PROF_FRAMES),render:new Float32Array(PROF_FRAMES)},
+      metrics:{},shownAt:0};
+    function profFrame(){
+      prof.frame++;
+      for(const k in prof.phases) prof.phases[k][prof.frame%PROF_FRAMES]=0;
+    }
+    // add the time since t0 to this frame's phase and return now for chaining
+    function profPhase(name,t0){
+      const now=performance.now();
+      prof.phases[name][prof.frame%PROF_FRAMES]+=now-t0;
+      return now;
+    }
+    function profShow(now){
+      if(!prof.on||now-prof.shownAt<500) return;
+      prof.shownAt=now;
+      const n=Math.min(prof.frame,PROF_FRAMES),parts=[];
+      for(const k in prof.phases){
+        const a=prof.phases[k];
+        let sum=0,max=0;
+        for(let i=0;i<n;i++){sum+=a[i]; max=Math.max(max,a[i]);}
+        parts.push(`${k} ${(sum/(n||1)).toFixed(2)}/${max.toFixed(2)} ms`);
+      }
+      for(const k in prof.metrics) parts.push(k+' '+prof.metrics[k]);
+      const queued=tasks.report();
+      for(const k in queued) parts.push(`task ${k} queued p95 ${queued[k].queuedP95.toFixed(1)} ms`);
+      profEl.textContent=parts.join(' · ');
+    }
+
+    // sound: see audio.js; press-to-sound latency goes to the profiler
+    const audio=opts.audio!==false&&window.MAFAudio&&MAFAudio.createAudio();
+    if(audio) audio.onLatency=ms=>{prof.metrics['press→sound']=ms.toFixed(1)+' ms';};
+
+    // the world (plane, obstacles, seeded RNG) lives in typed arrays in sim.js
+    // so it can be forked cheaply; ?seed=N replays or shares the first run's
+    // course (restarts draw fresh ones) and ?fixed runs the bit-exact
+    // fixed-point physics (race mode stays float, since the server owns the
+    // plane there). ?behaviors mixes bobbing, swinging and gate obstacles
+    // into random spawns; the race server and the fixed-point path spawn
+    // plain ones only. ?analytic moves the plane in closed form and steps
+    // each frame at once outside time-of-impact windows (see advance());
+    // race and ?fixed keep their own stepping.
+    let firstSeed=+params.get('seed')||0;
+    const newSeed=()=>{const s=firstSeed; firstSeed=0; return s||(Math.random()*4294967296)>>>0;};
+    const world=MAFSim.createWorld(newSeed(),32,params.has('fixed')&&!params.has('race'));
+    if(params.has('behaviors')&&!params.has('race'))
+      world.spawnKinds=[MAFSim.LINEAR,MAFSim.BOB,MAFSim.PENDULUM,MAFSim.GATE];
+    world.analytic=params.has('analytic')&&!params.has('race')&&!world.fixed;
+
+    let running=true,gameOver=false,victory=false,endedAt=0;
+    const plane=world.plane;
+    let hold=false;
+    let last=0,acc=0;
+    let kmRemaining=12000;
+    const KM_PER_SEC=100/60;
+
+    // run statistics (stats.js): streaming summaries fed from update() and
+    // frame(), in fixed memory however long the run; summarized when it ends
+    const runStats=MAFStats.createRunStats();
+    let runSummary=null;
+    function summarizeRun(){
+      const r=runStats.summary(),a=r.altitude,n=r.nearMiss,f=r.frameMs;
+      const px=v=>isFinite(v)?Math.round(v):'–',ms=v=>isFinite(v)?v.toFixed(1):'–';
+      r.lines=[
+        `altitude p10/p50/p90 ${px(a.p10)}/${px(a.p50)}/${px(a.p90)} px · holding ${Math.round(r.hold.duty*100)}% (${r.hold.presses} presses)`,
+        `${n.count} near misses${n.count?` (closest ${px(n.closest)} px)`:''} · frame p50/p99 ${ms(f.p50)}/${ms(f.p99)} ms`,
+      ];
+      return r;
+    }
+
+    // cosmetic randomness has its own stream so it never disturbs the course
+    const fxRand=MAFSim.rng(newSeed());
+
+    // heart particles: every emitter draws from one fixed pool, so the budget is
+    // global; slots are handed out round-robin, which recycles the oldest first
+    const MAX_PARTICLES=256,HEART_LIFE=1;
+    const particles=[];
+    for(let i=0;i<MAX_PARTICLES;i++) particles.push({x:0,y:0,vx:0,vy:0,life:0});
+    let particleHead=0,liveParticles=0;
+    function emit(e,i,n){
+      const p=particles[particleHead];
+      particleHead=(particleHead+1)%MAX_PARTICLES;
+      p.x=plane.x+e.ox; p.y=plane.y+e.oy; p.life=HEART_LIFE;
+      e.shape(p,i,n);
+    }
+    // spread n hearts evenly over an arc (random within it for single hearts)
+    function fan(dir,spread,minSpeed,maxSpeed){
+      return (p,i,n)=>{
+        const a=dir+(n>1?i/(n-1)-0.5:fxRand()-0.5)*spread,
+              s=minSpeed+fxRand()*(maxSpeed-minSpeed);
+        p.vx=Math.cos(a)*s; p.vy=Math.sin(a)*s;
+      };
+    }
+    // rate: hearts/s while holding, burst: hearts on the press edge
+    const emitters=[
+      {ox:20,oy:0,rate:8,burst:5,acc:0,shape:fan(Math.PI+0.45,0.5,130,260)},
+    ];
+    function burstEmitters(){
+      emitters.forEach(e=>{for(let i=0;i<e.burst;i++) emit(e,i,e.burst);});
+    }
+    function updateEmitters(dt){
+      emitters.forEach(e=>{
+        if(!hold){e.acc=0;return;}
+        e.acc+=e.rate*dt;
+        for(;e.acc>=1;e.acc--) emit(e,0,1);
+      });
+    }
+    function updateParticles(dt){
+      liveParticles=0;
+      for(let i=0;i<MAX_PARTICLES;i++){
+        const p=particles[i];
+        if(p.life<=0) continue;
+        liveParticles++;
+        p.x+=p.vx*dt; p.y+=p.vy*dt; p.life-=dt;
+        const c=gridCell(p.x,p.y);
+        for(let k=grid.start[c],end=grid.start[c+1];k<end;k++){
+          const o=grid.items[k],ox=world.ox[o],oy=world.oy[o];
+          if(p.x<ox||p.x>ox+world.ow[o]||p.y<oy||p.y>oy+world.oh[o]) continue;
+          // bounce off the face we came through and burn half the remaining life
+          if(p.x-p.vx*dt<ox||p.x-p.vx*dt>ox+world.ow[o]) p.vx=-p.vx*0.6;
+          else p.vy=-p.vy*0.6;
+          p.x+=p.vx*dt; p.y+=p.vy*dt; p.life*=0.5;
+          break;
+        }
+      }
+    }
+    function drawParticles(){
+      particles.forEach(p=>{
+        if(p.life<=0) return;
+        ctx.globalAlpha=p.life/HEART_LIFE;
+        drawText("💜","16px sans-serif",'#fff',p.x,p.y);
+      });
+      ctx.globalAlpha=1;
+    }
+
+    function press(){
+      if(hold) return false; // only the edge bursts
+      hold=true; burstEmitters();
+      if(audio){audio.setThrust(true); audio.play('puff'); audio.play('heart',0.5);}
+      return true;
+    }
+    function release(){
+      hold=false;
+      if(audio) audio.setThrust(false);
+    }
+    // attract mode: ?attract lets the autopilot (bot.js) fly until someone presses
+    let autopilot=params.has('attract')?MAFBot.createBot({budgetMs:opts.botBudgetMs||4}):null;
+    function userPress(e){
+      autopilot=null;
+      if(audio) audio.unlock();
+      if(!running){if(!race.ws) restart(); return;}
+      if(press()&&audio) audio.measure(e.timeStamp);
+    }
+    // only the interactive instance listens; attract-mode wall instances fly alone
+    const interactive=opts.input!==false;
+    if(interactive){
+      window.addEventListener('keydown',e=>{if(e.code==="Space"&&!e.repeat)userPress(e);},{signal});
+      window.addEventListener('keyup',e=>{if(e.code==="Space")release();},{signal});
+      window.addEventListener('mousedown',userPress,{signal});
+      window.addEventListener('mouseup',release,{signal});
+      window.addEventListener('touchstart',e=>{e.preventDefault();userPress(e);},{passive:false,signal});
+      window.addEventListener('touchend',e=>{e.preventDefault();release();},{passive:false,signal});
+    }
+
+    // contrail: exhaust positions in a fixed ring, recorded at sim rate and
+    // drifted left at TRAIL_SPEED; points are only kept when the exhaust has
+    // moved or enough time has passed, so slow flight stores few of them
+    const TRAIL_LEN=64,TRAIL_AGE=0.8,TRAIL_SPEED=160,TRAIL_WIDTH=4;
+    const trailT=new Float32Array(TRAIL_LEN),trailX=new Float32Array(TRAIL_LEN),trailY=new Float32Array(TRAIL_LEN);
+    const trailPx=new Float32Array(TRAIL_LEN+1),trailPy=new Float32Array(TRAIL_LEN+1);
+    let trailHead=0,trailCount=0,trailGradient=null;
+    function recordTrail(){
+      const x=plane.x-12*Math.cos(plane.tilt),y=plane.y-12*Math.sin(plane.tilt);
+      if(trailCount){
+        const k=(trailHead+TRAIL_LEN-1)%TRAIL_LEN,age=world.elapsed-trailT[k];
+        if(Math.abs(y-trailY[k])<2&&age<0.1) return;
+      }
+      trailT[trailHead]=world.elapsed; trailX[trailHead]=x; trailY[trailHead]=y;
+      trailHead=(trailHead+1)%TRAIL_LEN;
+      if(trailCount<TRAIL_LEN) trailCount++;
+    }
+    // the whole trail is one tapered polygon and a single fill
+    function drawTrail(){
+      let n=0;
+      trailPx[n]=plane.x-12*Math.cos(plane.tilt); trailPy[n++]=plane.y-12*Math.sin(plane.tilt);
+      for(let i=1;i<=trailCount;i++){
+        const k=(trailHead+TRAIL_LEN-i)%TRAIL_LEN,age=world.elapsed-trailT[k];
+        if(age>TRAIL_AGE) break;
+        trailPx[n]=trailX[k]-age*TRAIL_SPEED; trailPy[n++]=trailY[k];
+      }
+      if(n<2) return;
+      if(!trailGradient){
+        trailGradient=ctx.createLinearGradient(plane.x-TRAIL_AGE*TRAIL_SPEED,0,plane.x,0);
+        trailGradient.addColorStop(0,'rgba(255,140,60,0)');
+        trailGradient.addColorStop(1,'rgba(255,220,160,0.8)');
+      }
+      // walk out along one edge and back along the other, offsetting each point
+      // along its normal by a half-width that tapers to zero at the tail
+      ctx.beginPath();
+      for(let pass=0;pass<2;pass++){
+        const side=pass?-1:1;
+        for(let j=0;j<n;j++){
+          const i=pass?n-1-j:j,a=Math.max(0,i-1),b=Math.min(n-1,i+1);
+          const dx=trailPx[b]-trailPx[a],dy=trailPy[b]-trailPy[a];
+          const len=Math.hypot(dx,dy)||1,hw=TRAIL_WIDTH*(1-i/(n-1))*side;
+          const x=trailPx[i]-dy/len*hw,y=trailPy[i]+dx/len*hw;
+          if(pass||j) ctx.lineTo(x,y); else ctx.moveTo(x,y);
+        }
+      }
+      ctx.fillStyle=trailGradient;
+      ctx.fill();
+    }
+
+    function drawPlane(p){
+      if(p===plane) drawTrail();
+      ctx.save();
+      ctx.translate(p.x,p.y);
+      ctx.rotate(p.tilt);
+      drawPlaneShape(ctx,true);
+      ctx.restore();
+    }
+
+    // pixel-exact collision against the shared masks (see buildMasks)
+    function planeHits(){
+      const f=MAFSim.maskFrame(masks,plane.tilt);
+      const px=Math.round(plane.x)+f.x,py=Math.round(plane.y)+f.y;
+      const n=queryGrid(px,py,px+f.w,py+f.h);
+      for(let k=0;k<n;k++) if(MAFSim.maskHitsObstacle(f,px,py,world,grid.hits[k])) return true;
+      return false;
+    }
+
+    // uniform-grid spatial hash over the obstacles, rebuilt every step by a
+    // counting sort into typed arrays; storage only grows, so steady state
+    // allocates nothing. Points outside the canvas clamp to the edge cells.
+    const grid={size:64,cols:1,rows:1,
+      start:new Int32Array(2),cursor:new Int32Array(1),items:new Int32Array(64),
+      stamp:new Int32Array(64),query:0,hits:new Int32Array(64)};
+    function gridCol(x){return Math.min(grid.cols-1,Math.max(0,Math.floor(x/grid.size)));}
+    function gridRow(y){return Math.min(grid.rows-1,Math.max(0,Math.floor(y/grid.size)));}
+    function gridCell(x,y){return gridRow(y)*grid.cols+gridCol(x);}
+    function buildGrid(){
+      const g=grid;
+      g.cols=Math.ceil(W()/g.size)||1; g.rows=Math.ceil(H()/g.size)||1;
+      const n=g.cols*g.rows;
+      if(g.start.length<n+1){g.start=new Int32Array(n+1); g.cursor=new Int32Array(n);}
+      const start=g.start; start.fill(0,0,n+1);
+      let total=0;
+      for(let i=0;i<world.n;i++){
+        const c0=gridCol(world.ox[i]),c1=gridCol(world.ox[i]+world.ow[i]),r0=gridRow(world.oy[i]),r1=gridRow(world.oy[i]+world.oh[i]);
+        for(let r=r0;r<=r1;r++) for(let c=c0;c<=c1;c++){start[r*g.cols+c+1]++; total++;}
+      }
+      for(let c=0;c<n;c++) start[c+1]+=start[c];
+      if(g.items.length<total) g.items=new Int32Array(total*2);
+      if(g.stamp.length<world.n){
+        g.stamp=new Int32Array(world.n*2); g.hits=new Int32Array(world.n*2); g.query=0;
+      }
+      g.cursor.set(start.subarray(0,n));
+      for(let i=0;i<world.n;i++){
+        const c0=gridCol(world.ox[i]),c1=gridCol(world.ox[i]+world.ow[i]),r0=gridRow(world.oy[i]),r1=gridRow(world.oy[i]+world.oh[i]);
+        for(let r=r0;r<=r1;r++) for(let c=c0;c<=c1;c++) g.items[g.cursor[r*g.cols+c]++]=i;
+      }
+    }
+    // obstacle indices whose cells overlap the rect, deduplicated, into grid.hits
+    function queryGrid(x0,y0,x1,y1){
+      const g=grid,q=++g.query,c0=gridCol(x0),c1=gridCol(x1),r0=gridRow(y0),r1=gridRow(y1);
+      let n=0;
+      for(let r=r0;r<=r1;r++) for(let c=c0;c<=c1;c++){
+        const cell=r*g.cols+c;
+        for(let k=g.start[cell],end=g.start[cell+1];k<end;k++){
+          const i=g.items[k];
+          if(g.stamp[i]!==q){g.stamp[i]=q; g.hits[n++]=i;}
+        }
+      }
+      return n;
+    }
+
+    // hand-authored courses: ?course=file.mafc streams obstacles from
+    // course-worker.js instead of spawning them at random. The worker decodes a
+    // few hundred km ahead and only chunks not yet flown past are kept here.
+    // A record's kind picks its behavior and its param seeds the stream the
+    // behavior's parameters are drawn from, so a course replays exactly;
+    // fixed-point worlds fly every kind as LINEAR. Races ignore it: the
+    // server's world is the course.
+    const course={active:false,worker:null,chunkKm:0,chunks:new Map(),reported:-1,rng:MAFSim.rng(0)};
+    const courseUrl=!params.has('race')&&params.get('course');
+    function openCourse(){
+      if(course.worker) course.worker.terminate();
+      course.active=true; world.randomSpawns=false;
+      course.chunks.clear(); course.chunkKm=0; course.reported=-1;
+      course.worker=workers.channel('course-worker.js');
+      course.worker.onmessage=e=>{
+        const m=e.data;
+        if(m.type==='header') course.chunkKm=m.chunkKm;
+        else if(m.type==='chunk') course.chunks.set(m.index,{records:m.records,next:0});
+        else if(m.type==='end') course.worker.terminate();
+        else if(m.type==='error'){
+          console.warn('course '+courseUrl+': '+m.message+', falling back to random obstacles');
+          course.worker.terminate(); course.active=false; world.randomSpawns=true;
+        }
+      };
+      course.worker.postMessage({type:'open',url:courseUrl});
+    }
+    if(courseUrl&&window.Worker) openCourse();
+    // km of the earliest record not yet spawned
+    function nextRecordKm(){
+      let km=Infinity;
+      course.chunks.forEach(c=>{if(c.next<c.records.length) km=Math.min(km,c.records[c.next]);});
+      return km;
+    }
+    function updateCourse(km,dt){
+      if(!course.chunkKm) return;
+      const current=Math.floor(km/course.chunkKm);
+      if(current!==course.reported){
+        course.reported=current;
+        course.worker.postMessage({type:'km',km});
+      }
+      course.chunks.forEach((c,index)=>{
+        const r=c.records;
+        for(;c.next<r.length&&r[c.next]<=km;c.next+=6){
+          // analytic steps vary in length, so start the record where it
+          // would be had it spawned at its own km (it moves dt this step)
+          const speed=r[c.next+3],lead=world.analytic?dt-(km-r[c.next])/KM_PER_SEC:0;
+          const i=MAFSim.addObstacle(world,W()+20+speed*lead,r[c.next+1]*H(),30,r[c.next+2]*H(),speed);
+          const kind=r[c.next+4];
+          if(kind<MAFSim.KINDS&&!world.fixed){
+            course.rng.state=r[c.next+5];
+            MAFSim.respawnAs(world,i,kind,course.rng);
+          }
+        }
+        if(c.next>=r.length&&index<current) course.chunks.delete(index);
+      });
+    }
+
+    function drawObstacles(){
+      // pendulum ropes, from the pivot on the ceiling to the bob's centre
+      const p0=world.kindEnd[MAFSim.PENDULUM-1],p1=world.kindEnd[MAFSim.PENDULUM];
+      if(p1>p0){
+        ctx.strokeStyle='#088'; ctx.lineWidth=2;
+        ctx.beginPath();
+        for(let i=p0;i<p1;i++){
+          ctx.moveTo(world.op0[i],0);
+          ctx.lineTo(world.ox[i]+world.ow[i]/2,world.oy[i]+world.oh[i]/2);
+        }
+        ctx.stroke();
+      }
+      ctx.fillStyle='#0ff';
+      for(let i=0;i<world.n;i++) ctx.fillRect(world.ox[i],world.oy[i],world.ow[i],world.oh[i]);
+    }
+
+    function drawVictory(){
+      ctx.fillStyle='rgba(0,0,0,0.7)';
+      ctx.fillRect(0,0,W(),H());
+
+      // Hug PNG
+      if(hugImg.complete){
+        const scale=Math.min(W()/hugImg.width, H()/hugImg.height)*0.6;
+        const w=hugImg.width*scale;
+        const h=hugImg.height*scale;
+        ctx.drawImage(hugImg, W()/2-w/2, H()/2-h/2-30, w, h);
+      }
+
+      // Text
+      drawText('Victory! ✈️💞','28px system-ui,sans-serif','#fff',W()/2,80,'center');
+      drawText('Mini Aaron & Chandrima finally hug 💞','16px system-ui,sans-serif','#fff',W()/2,110,'center');
+      drawRunStats(H()-90);
+      if(recorder.worker) drawText('Press C to save a clip','16px system-ui,sans-serif','#fff',W()/2,H()-30,'center');
+    }
+
+    function drawOverlay(title,subtitle){
+      ctx.fillStyle='rgba(0,0,0,0.7)';
+      ctx.fillRect(0,0,W(),H());
+      drawText(title,'28px system-ui,sans-serif','#fff',W()/2,H()/2-40,'center');
+      drawText(subtitle,'16px system-ui,sans-serif','#fff',W()/2,H()/2-10,'center');
+      drawRunStats(H()/2+30);
+    }
+    function drawRunStats(y){
+      if(!runSummary) return;
+      runSummary.lines.forEach((l,i)=>drawPlainText(l,'14px system-ui,sans-serif','#aaa',W()/2,y+i*20,'center'));
+    }
+
+    // clip recording: canvas frames are copied into VideoFrames at CLIP_FPS and
+    // handed to recorder-worker.js, which keeps the last CLIP_SECONDS encoded;
+    // KeyC muxes them into a .webm download. Disable with ?record=0.
+    const CLIP_FPS=30,CLIP_SECONDS=20;
+    const recorder={worker:null,lastFrame:0,endedAt:0,saving:false};
+    if(params.get('record')!=='0'&&window.VideoEncoder&&window.VideoFrame&&window.Worker){
+      recorder.worker=workers.channel('recorder-worker.js',{exclusive:true});
+      recorder.worker.onmessage=e=>{
+        const m=e.data;
+        if(m.type==='error'){
+          console.warn('recorder: '+m.message);
+          recorder.worker.terminate(); recorder.worker=null;
+        }else if(m.type==='clip'){
+          recorder.saving=false;
+          if(!m.blob) return;
+          const a=document.createElement('a');
+          a.href=URL.createObjectURL(m.blob); a.download='mini-aaron-flight.webm';
+          a.click();
+          setTimeout(()=>URL.revokeObjectURL(a.href),1000);
+        }
+      };
+      recorder.worker.postMessage({type:'init',fps:CLIP_FPS,seconds:CLIP_SECONDS});
+    }
+    function captureFrame(ts){
+      if(!recorder.worker||ts-recorder.lastFrame<1000/CLIP_FPS-1) return;
+      // keep two seconds of the end screen, then stop so the run stays in the ring
+      if(!running){
+        if(!recorder.endedAt) recorder.endedAt=ts;
+        if(ts-recorder.endedAt>2000) return;
+      }
+      recorder.lastFrame=ts;
+      const frame=new VideoFrame(canvas,{timestamp:Math.round(ts*1000)});
+      recorder.worker.postMessage({type:'frame',frame},[frame]);
+    }
+    function saveClip(){
+      if(!recorder.worker||recorder.saving) return;
+      recorder.saving=true;
+      recorder.worker.postMessage({type:'clip'});
+    }
+    if(interactive) window.addEventListener('keydown',e=>{if(e.code==="KeyC"&&!e.repeat)saveClip();},{signal});
+
+    // race mode: ?race=ws://host:port joins server/race-server.js, which owns
+    // every plane. The local plane is predicted from our input history and
+    // replayed from the server state when a snapshot disagrees; remote planes
+    // are drawn INTERP_TICKS behind the server and interpolated between
+    // snapshots. Snapshots are deltas against one we acknowledged earlier.
+    // The server also decides crashes, against its own copy of the seeded
+    // obstacles: a plane's snapshot flags say when it hit something, which
+    // ends our run (there is no restart within a race) or hides a remote.
+    const NET={INPUT:1,ACK:2,PING:3,WELCOME:10,SNAPSHOT:11,PONG:12};
+    const FLAG_CRASHED=2;
+    const HISTORY=256,INTERP_TICKS=6,SNAPSHOTS_KEPT=64;
+    const race={ws:null,id:-1,tick:0,seq:0,sentHold:false,
+      holds:new Uint8Array(HISTORY),predY:new Float64Array(HISTORY),predVy:new Float64Array(HISTORY),
+      snapshots:new Map(),remotes:new Map(),serverTick:0,serverAt:0,rtt:100,
+      bytes:0,bps:0,statsAt:0,inputAt:0,inputSeq:0,pendingDisplay:false,displayMs:0,confirmMs:0};
+    function raceSend(bytes){
+      if(race.ws.readyState===1) race.ws.send(bytes);
+    }
+    function estServerTick(){
+      return race.serverTick+(performance.now()-race.serverAt)/1000/STEP;
+    }
+    // run ahead of the server by half the round trip plus a little margin, so
+    // inputs arrive before the server reaches the tick they are stamped with
+    function raceStepAdjust(){
+      if(!race.serverAt) return 0;
+      const lead=race.tick-estServerTick(),target=Math.ceil(race.rtt/2000/STEP)+2;
+      return lead>target+3?-1:lead<target-3?1:0;
+    }
+    function stepRacePlane(){
+      const t=++race.tick,k=t%HISTORY;
+      race.holds[k]=hold?1:0;
+      if(hold!==race.sentHold){
+        race.sentHold=hold;
+        const m=new DataView(new ArrayBuffer(10));
+        m.setUint8(0,NET.INPUT); m.setUint32(1,++race.seq,true); m.setUint32(5,t,true); m.setUint8(9,hold?1:0);
+        raceSend(m.buffer);
+        race.inputSeq=race.seq; race.inputAt=performance.now(); race.pendingDisplay=true;
+      }
+      MAFSim.stepPlane(plane,hold,STEP);
+      MAFSim.quantizePlane(plane);
+      race.predY[k]=plane.y; race.predVy[k]=plane.vy;
+    }
+    function onSnapshot(v){
+      const tick=v.getUint32(1,true),baseTick=v.getUint32(5,true),ackSeq=v.getUint32(9,true),count=v.getUint8(13);
+      const base=baseTick?race.snapshots.get(baseTick):null;
+      if(baseTick&&!base) return; // baseline already dropped; the server will move on
+      const snap=new Map(base);
+      for(let i=0,off=14;i<count;i++){
+        const id=v.getUint8(off),mask=v.getUint8(off+1);
+        off+=2;
+        if(mask&0x80){snap.delete(id); continue;}
+        const q=Object.assign({y:0,vy:0,flags:0},snap.get(id));
+        if(mask&1){q.y=v.getUint16(off,true); off+=2;}
+        if(mask&2){q.vy=v.getInt16(off,true); off+=2;}
+        if(mask&4) q.flags=v.getUint8(off++);
+        snap.set(id,q);
+      }
+      race.snapshots.set(tick,snap);
+      for(const t of race.snapshots.keys()) if(t<tick-SNAPSHOTS_KEPT*3) race.snapshots.delete(t);
+      const ack=new DataView(new ArrayBuffer(5));
+      ack.setUint8(0,NET.ACK); ack.setUint32(1,tick,true);
+      raceSend(ack.buffer);
+      if(tick>race.serverTick){race.serverTick=tick; race.serverAt=performance.now();}
+      if(ackSeq===race.inputSeq&&race.inputAt){race.confirmMs=performance.now()-race.inputAt; race.inputAt=0;}
+
+      snap.forEach((q,id)=>{
+        const y=q.y/MAFSim.Y_SCALE,vy=q.vy/MAFSim.VY_SCALE;
+        if(id===race.id){
+          // replay our inputs since the snapshot if the prediction drifted
+          const k=tick%HISTORY;
+          if(tick>race.tick||race.tick-tick>=HISTORY){
+            plane.y=y; plane.vy=vy; plane.tilt=vy/200; race.tick=Math.max(race.tick,tick);
+          }else if(race.predY[k]!==y||race.predVy[k]!==vy){
+            plane.y=y; plane.vy=vy;
+            for(let t=tick+1;t<=race.tick;t++){
+              const j=t%HISTORY;
+              MAFSim.stepPlane(plane,race.holds[j],STEP);
+              MAFSim.quantizePlane(plane);
+              race.predY[j]=plane.y; race.predVy[j]=plane.vy;
+            }
+          }
+          if(q.flags&FLAG_CRASHED&&running){
+            plane.y=y; plane.vy=vy; plane.tilt=vy/200;
+            crash();
+          }
+          return;
+        }
+        let r=race.remotes.get(id);
+        if(!r) race.remotes.set(id,r={samples:[],plane:{x:plane.x,y,vy,tilt:0}});
+        r.crashed=!!(q.flags&FLAG_CRASHED);
+        r.samples.push({tick,y,vy});
+        if(r.samples.length>16) r.samples.shift();
+      });
+      race.remotes.forEach((r,id)=>{if(!snap.has(id)) race.remotes.delete(id);});
+    }
+    function drawRemotePlanes(){
+      const t=estServerTick()-INTERP_TICKS;
+      ctx.globalAlpha=0.5;
+      race.remotes.forEach(r=>{
+        if(r.crashed) return;
+        const s=r.samples;
+        let i=0;
+        while(i<s.length-2&&s[i+1].tick<=t) i++;
+        const a=s[i],b=s[Math.min(i+1,s.length-1)],f=b.tick>a.tick?Math.max(0,Math.min(1,(t-a.tick)/(b.tick-a.tick))):0;
+        r.plane.y=a.y+(b.y-a.y)*f;
+        r.plane.tilt=(a.vy+(b.vy-a.vy)*f)/200;
+        drawPlane(r.plane);
+      });
+      ctx.globalAlpha=1;
+    }
+    // latency: input to the first frame showing it (prediction) and input to
+    // the snapshot confirming it; bandwidth is what we received per second
+    function updateRaceStats(){
+      const now=performance.now();
+      if(race.pendingDisplay){race.displayMs=now-race.inputAt; race.pendingDisplay=false;}
+      if(now-race.statsAt<1000) return;
+      race.bps=race.bytes*1000/(now-race.statsAt); race.bytes=0; race.statsAt=now;
+      const ping=new DataView(new ArrayBuffer(9));
+      ping.setUint8(0,NET.PING); ping.setFloat64(1,now,true);
+      raceSend(ping.buffer);
+      netEl.textContent=`race: ${race.remotes.size+1} planes, ${Math.round(race.rtt)} ms rtt, `+
+        `input ${race.displayMs.toFixed(0)}/${race.confirmMs.toFixed(0)} ms, ${(race.bps/1024).toFixed(1)} kB/s`;
+    }
+    const raceUrl=params.get('race');
+    if(raceUrl&&window.WebSocket){
+      race.ws=new WebSocket(raceUrl);
+      race.ws.binaryType='arraybuffer';
+      race.ws.onmessage=e=>{
+        const v=new DataView(e.data);
+        race.bytes+=e.data.byteLength;
+        const type=v.getUint8(0);
+        if(type===NET.WELCOME){
+          // everyone flies the server's seeded course from its current tick
+          race.id=v.getUint8(1); world.rng.state=v.getUint32(2,true);
+          race.serverTick=v.getUint32(6,true); race.serverAt=performance.now();
+          race.tick=race.serverTick+Math.ceil(race.rtt/2000/STEP)+2;
+          MAFSim.resetWorld(world,world.rng.state);
+          for(let t=0;t<race.tick;t++){world.elapsed+=STEP; updateObstacles(STEP);}
+        }else if(type===NET.SNAPSHOT) onSnapshot(v);
+        else if(type===NET.PONG) race.rtt=race.rtt*0.7+(performance.now()-v.getFloat64(1,true))*0.3;
+      };
+      race.ws.onclose=()=>{
+        netEl.textContent='race: disconnected';
+        race.ws=null; race.remotes.clear();
+      };
+    }
+
+    function updateObstacles(dt){
+      if(course.active) updateCourse(world.elapsed*KM_PER_SEC,dt);
+      MAFSim.stepObstacles(world,dt);
+    }
+
+    // analytic worlds take a frame's time in as few steps as the impact
+    // schedule allows: STEP-sized inside a window, otherwise straight to the
+    // next window, spawn or course record
+    const impactStats={steps:0,checks:0};
+    function advance(dt){
+      while(dt>1e-9&&running){
+        // the input may have changed since the last step scheduled them
+        MAFSim.updateImpacts(world,hold);
+        let h=MAFSim.analyticStep(world,dt);
+        if(course.active) h=Math.min(h,Math.max(1e-6,nextRecordKm()/KM_PER_SEC-world.elapsed+1e-6));
+        update(h); dt-=h;
+      }
+      if(impactStats.steps>=600){
+        prof.metrics.collide=`${impactStats.checks}/${impactStats.steps} steps`;
+        impactStats.steps=impactStats.checks=0;
+      }
+    }
+
+    // a press after the run ends starts a new one (attract mode restarts itself)
+    function restart(){
+      MAFSim.resetWorld(world,newSeed());
+      particles.forEach(p=>{p.life=0;});
+      trailCount=0;
+      if(course.active) openCourse();
+      running=true; gameOver=false; victory=false; endedAt=0; recorder.endedAt=0;
+      runStats.reset(); runSummary=null;
+    }
+    function crash(){
+      gameOver=true; end();
+      if(audio) audio.play('crash');
+    }
+    function end(){
+      running=false; endedAt=performance.now();
+      runSummary=summarizeRun();
+    }
+
+    function update(dt){
+      if(!running)return;
+      world.elapsed+=dt;
+
+      if(race.ws) stepRacePlane();
+      else if(world.fixed) MAFSim.stepPlaneFixed(world,hold);
+      else if(world.analytic) MAFSim.advancePlane(plane,hold,dt);
+      else MAFSim.stepPlane(plane,hold,dt);
+      recordTrail();
+
+      updateObstacles(dt);
+      buildGrid();
+      // in race mode the server tests for crashes (see onSnapshot); analytic
+      // worlds test only while an impact window is open
+      let check=!race.ws;
+      if(world.analytic){
+        MAFSim.updateImpacts(world,hold);
+        check=MAFSim.impactOpen(world);
+        impactStats.steps++; impactStats.checks+=check;
+      }
+      if(check&&planeHits()){crash(); return;}
+
+      runStats.step(FIELD_H-20-plane.y,hold,MAFBot.clearance(world),dt);
+      updateEmitters(dt);
+      updateParticles(dt);
+
+      kmRemaining=Math.max(0,12000-Math.floor(world.elapsed*KM_PER_SEC));
+      kmEl.textContent=kmRemaining.toLocaleString()+" km";
+
+      const m=Math.floor(world.elapsed/60).toString().padStart(2,'0'),
+            s=Math.floor(world.elapsed%60).toString().padStart(2,'0');
+      timerEl.textContent=`${m}:${s}`;
+
+      if(kmRemaining<=0){
+        victory=true; end();
+        if(audio) audio.play('victory');
+      }
+    }
+
+    function render(){
+      ctx.setTransform(viewScale,0,0,viewScale,0,0);
+      ctx.fillStyle='#001'; ctx.fillRect(0,0,W(),H());
+      drawObstacles();
+      drawParticles();
+      if(race.ws) drawRemotePlanes();
+      drawPlane(plane);
+      if(autopilot) drawText('Autopilot · press to fly','16px system-ui,sans-serif','#fff',W()/2,H()-30,'center');
+      if(gameOver) drawOverlay('Game Over 💔','Mini Aaron crashed!');
+      if(victory) drawVictory();
+    }
+
+    // rendering equivalence harness: ?harness flies each seeded scenario with
+    // scripted input, then renders the final state with every entry of
+    // RENDERERS on a fixed 1280x720 canvas. Frames are hashed and diffed
+    // against 'reference' (plain Canvas2D, no caches): a renderer passes when
+    // at most maxRatio of pixels differ by more than tol in any channel.
+    // Frame times are the mean of `repeat` renders including a readback.
+    // The JSON result lands in window.MAF_RESULT for tools/headless.js.
+    const RENDERERS={
+      reference:{textCache:false},
+      optimized:{textCache:true},
+    };
+    const SCENARIOS=[
+      {name:'cruise',seed:1,steps:900,input:i=>i%100<45},
+      {name:'crash',seed:2,steps:4000,input:()=>false},
+      {name:'victory',seed:3,steps:60,from:12000/KM_PER_SEC-0.5,input:i=>i%30<10},
+      {name:'attract',seed:4,steps:600,bot:true},
+    ];
+    function frameHash(d){
+      let h=0x811c9dc5;
+      for(let i=0;i<d.length;i+=4){h^=d[i]|d[i+1]<<8|d[i+2]<<16; h=Math.imul(h,0x01000193);}
+      return (h>>>0).toString(16).padStart(8,'0');
+    }
+    async function runHarness(){
+      const tol=+params.get('tol')||64,maxRatio=+params.get('ratio')||0.01,repeat=+params.get('repeat')||30;
+      await Promise.all([chibiAaron.decode(),hugImg.decode()]).catch(()=>{});
+      buildMasks(true);
+      // loop() never runs here, so observer reports are recorded but not applied
+      canvas.width=view.w=FIELD_W; canvas.height=view.h=FIELD_H; setScale(1);
+      const result={tol,maxRatio,repeat,pass:true,scenarios:[]};
+      for(const sc of SCENARIOS){
+        restart(); MAFSim.resetWorld(world,sc.seed); fxRand.state=sc.seed;
+        if(sc.from) world.elapsed=sc.from;
+        autopilot=sc.bot?MAFBot.createBot({budgetMs:Infinity}):null;
+        for(let i=0;i<sc.steps&&running;i++){
+          const h=autopilot?autopilot.think(world):sc.input(i);
+          if(h!==hold) h?press():release();
+          update(STEP);
+        }
+        const out={name:sc.name,steps:Math.round(world.elapsed/STEP),renderers:{}};
+        let ref=null;
+        for(const name in RENDERERS){
+          Object.assign(renderOpts,RENDERERS[name]); textCache.clear();
+          render();
+          const data=ctx.getImageData(0,0,FIELD_W,FIELD_H).data,r={hash:frameHash(data)};
+          const t0=performance.now();
+          for(let i=0;i<repeat;i++){render(); ctx.getImageData(0,0,1,1);}
+          r.ms=+((performance.now()-t0)/repeat).toFixed(3);
+          if(!ref) ref={data,ms:r.ms};
+          else{
+            let diff=0,max=0;
+            for(let i=0;i<data.length;i+=4){
+              const d=Math.max(Math.abs(data[i]-ref.data[i]),Math.abs(data[i+1]-ref.data[i+1]),
+                Math.abs(data[i+2]-ref.data[i+2]),Math.abs(data[i+3]-ref.data[i+3]));
+              if(d>tol) diff++;
+              if(d>max) max=d;
+            }
+            r.diffRatio=+(diff/(FIELD_W*FIELD_H)).toFixed(6); r.maxDelta=max;
+            r.speedup=+(ref.ms/r.ms).toFixed(3);
+            r.pass=r.diffRatio<=maxRatio;
+            if(!r.pass) result.pass=false;
+          }
+          out.renderers[name]=r;
+        }
+        result.scenarios.push(out);
+      }
+      Object.assign(renderOpts,RENDERERS.optimized);
+      window.MAF_RESULT=result;
+      profEl.textContent='harness '+(result.pass?'passed':'FAILED');
+      console.log(JSON.stringify(result,null,2));
+    }
+
+    const game={canvas,params,interactive,visible:true,area:0,decimate:1,minDecimate:1,
+      frame,restart,destroy,stats:()=>runSummary||summarizeRun(),
+      get running(){return running;},get world(){return world;}};
+
+    // fixed-step simulation, ticked by the shared scheduler (every frame, or
+    // every game.decimate frames); a long stall is dropped rather than replayed
+    function frame(ts){
+      if(!last) last=ts;
+      // a decimated instance's ts-last spans several frames, so record the
+      // display frame instead
+      if(running&&scheduler.frameMs>0) runStats.frame(scheduler.frameMs);
+      acc=Math.min(acc+(ts-last)/1000,STEP*8); last=ts;
+      let steps=Math.floor(acc/STEP);
+      acc-=steps*STEP;
+      if(race.ws) steps=Math.max(0,steps+raceStepAdjust());
+      profFrame();
+      if(view.dirty) applyResize();
+      let t=performance.now();
+      if(autopilot&&!running&&ts-endedAt>3000) restart();
+      if(autopilot&&running&&steps){
+        const h=autopilot.think(world);
+        if(h!==hold) h?press():release();
+      }
+      if(world.analytic) advance(steps*STEP);
+      else for(let i=0;i<steps;i++) update(STEP);
+      t=profPhase('update',t);
+      if(race.ws) updateRaceStats();
+      render();
+      profPhase('render',t);
+      if(watchdog.active){
+        const k=prof.frame%PROF_FRAMES;
+        watchdog.add(prof.phases.update[k],prof.phases.render[k],world.n,liveParticles);
+      }
+      profShow(t);
+      captureFrame(ts);
+    }
+    function destroy(){
+      scheduler.remove(game);
+      if(ro) ro.disconnect();
+      listeners.abort();
+      assets.textCache(0,textCache);
+      if(course.worker) course.worker.terminate();
+      if(recorder.worker) recorder.worker.terminate();
+      if(race.ws) race.ws.close();
+      if(audio) audio.ctx.close();
+    }
+    if(params.has('watchdog')) watchdog.start(+params.get('watchdog')||STALL_MS);
+    if(params.has('harness')) runHarness();
+    else scheduler.add(game);
+    return game;
+  }
+
+  root.MAFGame={create,assets,workers,scheduler,tasks,watchdog};
+})(this);
@@ -0,0 +1,130 @@
+// Keeps the last few seconds of gameplay encoded and muxes them on request.
+//
+// The game transfers VideoFrames copied from its canvas; they are encoded
+// here with a software VP8 encoder and the encoded chunks go into a bounded
+// ring that always starts on a keyframe. Nothing is muxed until a clip is
+// asked for, at which point the ring is written out as a WebM file.
+const KEY_INTERVAL=1; // seconds between forced keyframes
+
+let encoder=null,config=null,fps=30,seconds=20;
+let ring=[],head=0,count=0,frames=0,failed=false;
+
+function configure(width,height){
+  config={codec:'vp8',width,height,bitrate:2500000,framerate:fps,
+    hardwareAcceleration:'prefer-software',latencyMode:'realtime'};
+  if(encoder&&encoder.state!=='closed') encoder.close();
+  encoder=new VideoEncoder({output:store,error:e=>{failed=true; postMessage({type:'error',message:e.message});}});
+  encoder.configure(config);
+  ring=new Array(Math.ceil(fps*(seconds+KEY_INTERVAL*2))); head=0; count=0; frames=0;
+}
+
+function at(i){return ring[(head+i)%ring.length];}
+
+// append a chunk, then drop whole keyframe groups from the front while the
+// remainder still covers the clip window (or the ring is full)
+function store(chunk){
+  const data=new Uint8Array(chunk.byteLength);
+  chunk.copyTo(data);
+  const c={data,timestamp:chunk.timestamp,key:chunk.type==='key'};
+  if(count===ring.length) dropGroup();
+  ring[(head+count)%ring.length]=c; count++;
+  while(count>1&&c.timestamp-at(0).timestamp>seconds*1e6){
+    let next=1;
+    while(next<count&&!at(next).key) next++;
+    if(next===count||c.timestamp-at(next).timestamp<seconds*1e6) break;
+    dropGroup();
+  }
+}
+function dropGroup(){
+  do{ring[head]=undefined; head=(head+1)%ring.length; count--;}
+  while(count&&!at(0).key);
+}
+
+// minimal WebM writer: EBML header, one video track, a cluster per keyframe
+function vint(n){
+  let len=1;
+  while(len<8&&n>=2**(7*len)-1) len++;
+  const out=new Uint8Array(len);
+  for(let i=len-1;i>=0;i--){out[i]=n&0xff; n=Math.floor(n/256);}
+  out[0]|=0x80>>(len-1);
+  return out;
+}
+function uint(n){
+  const out=[];
+  do{out.unshift(n&0xff); n=Math.floor(n/256);}while(n>0);
+  return new Uint8Array(out);
+}
+function float(n){
+  const out=new Uint8Array(8);
+  new DataView(out.buffer).setFloat64(0,n);
+  return out;
+}
+function concat(parts){
+  let len=0;
+  for(const p of parts) len+=p.length;
+  const out=new Uint8Array(len);
+  let off=0;
+  for(const p of parts){out.set(p,off); off+=p.length;}
+  return out;
+}
+function el(id,...body){
+  const data=concat(body.map(b=>typeof b==='string'?new TextEncoder().encode(b):b));
+  return concat([uint(id),vint(data.length),data]);
+}
+function simpleBlock(c,clusterMs){
+  const head=new Uint8Array(4);
+  head[0]=0x81; // track 1
+  new DataView(head.buffer).setInt16(1,Math.round(c.timestamp/1000)-clusterMs);
+  head[3]=c.key?0x80:0;
+  return el(0xa3,head,c.data);
+}
+function mux(){
+  const t0=at(0).timestamp,clusters=[];
+  let cluster=null,clusterMs=0;
+  for(let i=0;i<count;i++){
+    const c=at(i),ms=Math.round((c.timestamp-t0)/1000);
+    if(c.key||ms-clusterMs>30000){
+      if(cluster) clusters.push(el(0x1f43b675,...cluster));
+      clusterMs=ms; cluster=[el(0xe7,uint(ms))];
+    }
+    cluster.push(simpleBlock({...c,timestamp:c.timestamp-t0},clusterMs));
+  }
+  if(cluster) clusters.push(el(0x1f43b675,...cluster));
+  const duration=(at(count-1).timestamp-t0)/1000+1000/fps;
+  return [
+    el(0x1a45dfa3,el(0x4286,uint(1)),el(0x42f7,uint(1)),el(0x42f2,uint(4)),
+      el(0x42f3,uint(8)),el(0x4282,'webm'),el(0x4287,uint(2)),el(0x4285,uint(2))),
+    el(0x18538067,
+      el(0x1549a966,el(0x2ad7b1,uint(1000000)),el(0x4489,float(duration)),
+        el(0x4d80,'mini-aaron-flight'),el(0x5741,'mini-aaron-flight')),
+      el(0x1654ae6b,el(0xae,el(0xd7,uint(1)),el(0x73c5,uint(1)),el(0x83,uint(1)),
+        el(0x86,'V_VP8'),el(0xe0,el(0xb0,uint(config.width)),el(0xba,uint(config.height))))),
+      ...clusters)
+  ];
+}
+
+onmessage=async e=>{
+  const m=e.data;
+  if(m.type==='init'){
+    fps=m.fps; seconds=m.seconds;
+  }else if(m.type==='frame'){
+    const f=m.frame;
+    if(failed){f.close(); return;}
+    // encode at even dimensions; a size change starts a fresh recording
+    const w=f.displayWidth&~1,h=f.displayHeight&~1;
+    if(!config||config.width!==w||config.height!==h) configure(w,h);
+    // shed frames rather than queue them when the encoder falls behind
+    if(encoder.encodeQueueSize>2){f.close(); return;}
+    const frame=w===f.displayWidth&&h===f.displayHeight?f:
+      new VideoFrame(f,{visibleRect:{x:0,y:0,width:w,height:h}});
+    encoder.encode(frame,{keyFrame:frames++%Math.round(fps*KEY_INTERVAL)===0});
+    if(frame!==f) frame.close();
+    f.close();
+  }else if(m.type==='clip'){
+    if(!encoder||failed){postMessage({type:'clip',blob:null}); return;}
+    await encoder.flush();
+    // flushing ends the current group, so the next frame must be a keyframe
+    frames=0;
+    postMessage({type:'clip',blob:count?new Blob(mux(),{type:'video/webm'}):null});
+  }
+};
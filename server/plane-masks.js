@@ -0,0 +1,41 @@
+// The plane's hit masks for the race server, so a plane crashes here exactly
+// when it would in single player. The page rasterizes drawPlaneShape on a
+// canvas; Node has none, so this draws the same geometry from sim.js in
+// software: the hull triangle sampled at pixel centres, and the rider sprite
+// box-filtered down to RIDER_SIZE (as a canvas draws it) then sampled
+// bilinearly, composited over it. Built once at load; Sim.packMask packs
+// each frame the same way the page does.
+const fs=require('fs'),path=require('path');
+const Sim=require('../sim.js');
+const {decodePng,downscale}=require('../tools/png.js');
+
+const {HULL,RIDER_SIZE,RIDER_LIFT,MASK_FRAMES,MASK_SIZE}=Sim;
+const rider=downscale(decodePng(fs.readFileSync(path.join(__dirname,'..','chibi-aaron.png'))),Math.round(RIDER_SIZE));
+const riderW=RIDER_SIZE,riderH=RIDER_SIZE*rider.h/rider.w;
+
+// rider alpha (0..255) at plane-local (x,y)
+function riderAlpha(x,y){
+  const u=(x+riderW/2)/riderW*rider.w-0.5,v=(y+riderH+RIDER_LIFT)/riderH*rider.h-0.5;
+  if(u<=-1||v<=-1||u>=rider.w||v>=rider.h) return 0;
+  const x0=Math.floor(u),y0=Math.floor(v),fx=u-x0,fy=v-y0;
+  const at=(x,y)=>x<0||y<0||x>=rider.w||y>=rider.h?0:rider.px[(y*rider.w+x)*4+3];
+  return (at(x0,y0)*(1-fx)+at(x0+1,y0)*fx)*(1-fy)+(at(x0,y0+1)*(1-fx)+at(x0+1,y0+1)*fx)*fy;
+}
+function inHull(x,y){
+  const [ax,ay,bx,by,cx,cy]=HULL;
+  const d1=(bx-ax)*(y-ay)-(by-ay)*(x-ax),d2=(cx-bx)*(y-by)-(cy-by)*(x-bx),d3=(ax-cx)*(y-cy)-(ay-cy)*(x-cx);
+  return !((d1<0||d2<0||d3<0)&&(d1>0||d2>0||d3>0));
+}
+
+function frame(angle){
+  const S=MASK_SIZE,alpha=new Uint8Array(S*S),c=Math.cos(angle),s=Math.sin(angle);
+  for(let y=0;y<S;y++) for(let x=0;x<S;x++){
+    // pixel centre back into the plane's unrotated frame
+    const qx=x+0.5-S/2,qy=y+0.5-S/2,lx=c*qx+s*qy,ly=-s*qx+c*qy;
+    const r=riderAlpha(lx,ly)/255,h=inHull(lx,ly)?1:0;
+    alpha[y*S+x]=Math.round((r+h*(1-r))*255);
+  }
+  return Sim.packMask(alpha);
+}
+
+module.exports=Array.from({length:MASK_FRAMES},(_,f)=>frame(Sim.maskAngle(f)));
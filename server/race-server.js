@@ -0,0 +1,194 @@
+// Authoritative race server for ?race=ws://host:port.
+//   node server/race-server.js [port]
+//
+// Steps every plane with sim.js at the fixed STEP, along with the race's
+// seeded obstacle world, and crashes a plane whose hit mask (single
+// player's, see plane-masks.js) touches an obstacle; a crashed plane stays
+// where it hit. Sends each client a quantized snapshot every SNAPSHOT_EVERY
+// ticks, delta-compressed against the last snapshot that client acknowledged. A per-client token bucket
+// caps snapshot bandwidth at BYTES_PER_SEC; snapshots that do not fit are
+// skipped and the next one is encoded against the same baseline.
+//
+// Messages are little-endian binary WebSocket frames:
+//   client  1 input     u32 seq, u32 tick, u8 hold
+//           2 ack       u32 snapshot tick
+//           3 ping      f64 client time
+//   server 10 welcome   u8 player id, u32 seed, u32 tick
+//          11 snapshot  u32 tick, u32 base tick (0: none), u32 last input
+//                       seq, u8 count, then per plane u8 id, u8 mask and
+//                       the fields set in mask: 1 u16 y, 2 i16 vy, 4 u8
+//                       flags (1 holding, 2 crashed); mask 0x80 means the
+//                       plane left
+//          12 pong      f64 client time, echoed
+const http=require('http'),crypto=require('crypto');
+const Sim=require('../sim.js');
+const masks=require('./plane-masks.js');
+
+const PORT=+(process.argv[2]||8080);
+const SNAPSHOT_EVERY=3,HISTORY=32,BYTES_PER_SEC=4096,MAX_PENDING_INPUTS=64,MAX_PLAYERS=255;
+const NET={INPUT:1,ACK:2,PING:3,WELCOME:10,SNAPSHOT:11,PONG:12};
+const FLAG_HOLD=1,FLAG_CRASHED=2;
+
+const players=new Map();
+let tick=0,seed=newSeed();
+// the obstacles every client also simulates from the seed, one step per tick
+const world=Sim.createWorld(seed);
+function newSeed(){return crypto.randomBytes(4).readUInt32LE(0)||1;}
+
+// --- minimal RFC 6455 framing, enough for small binary messages ---
+function send(socket,payload){
+  const len=payload.length,head=Buffer.alloc(len<126?2:4);
+  head[0]=0x82;
+  if(len<126) head[1]=len;
+  else{head[1]=126; head.writeUInt16BE(len,2);}
+  socket.write(Buffer.concat([head,payload]));
+  return head.length+len;
+}
+function parseFrames(p,onMessage){
+  for(;;){
+    const b=p.buffer;
+    if(b.length<2) return;
+    const op=b[0]&0x0f,masked=b[1]&0x80;
+    let len=b[1]&0x7f,off=2;
+    if(len===126){if(b.length<4) return; len=b.readUInt16BE(2); off=4;}
+    else if(len===127){if(b.length<10) return; len=Number(b.readBigUInt64BE(2)); off=10;}
+    if(b.length<off+(masked?4:0)+len) return;
+    const mask=masked?b.subarray(off,off+4):null;
+    if(masked) off+=4;
+    const data=Buffer.from(b.subarray(off,off+len));
+    if(mask) for(let i=0;i<len;i++) data[i]^=mask[i&3];
+    p.buffer=b.subarray(off+len);
+    if(op===0x8){p.socket.end(); return;}
+    if(op===0x9){p.socket.write(Buffer.concat([Buffer.from([0x8a,data.length]),data])); continue;}
+    if(op===0x1||op===0x2) onMessage(data);
+  }
+}
+
+// --- players ---
+function join(socket){
+  let id=0;
+  while(players.has(id)) id++;
+  // ids 0..254: a snapshot lists every plane in it or its baseline, and its
+  // count is a u8
+  if(id>=MAX_PLAYERS){socket.destroy(); return null;}
+  const p={id,socket,buffer:Buffer.alloc(0),plane:{x:world.plane.x,y:Sim.FIELD_H/2,vy:0,tilt:0},hold:false,crashed:false,
+    inputs:[],lastSeq:0,acked:0,history:new Map(),tokens:BYTES_PER_SEC,bytes:0,dropped:0};
+  players.set(id,p);
+  const w=Buffer.alloc(10);
+  w[0]=NET.WELCOME; w[1]=id; w.writeUInt32LE(seed,2); w.writeUInt32LE(tick,6);
+  send(socket,w);
+  console.log(`player ${id} joined (${players.size} connected)`);
+  return p;
+}
+function leave(p){
+  if(!players.delete(p.id)) return;
+  console.log(`player ${p.id} left (${players.size} connected)`);
+  // an empty server starts a fresh race on a new course
+  if(!players.size){tick=0; seed=newSeed(); Sim.resetWorld(world,seed);}
+}
+function onMessage(p,m){
+  if(m[0]===NET.INPUT&&m.length>=10){
+    if(p.inputs.length<MAX_PENDING_INPUTS)
+      p.inputs.push({seq:m.readUInt32LE(1),tick:m.readUInt32LE(5),hold:!!m[9]});
+  }else if(m[0]===NET.ACK&&m.length>=5){
+    p.acked=Math.max(p.acked,m.readUInt32LE(1));
+  }else if(m[0]===NET.PING&&m.length>=9){
+    const r=Buffer.from(m.subarray(0,9)); r[0]=NET.PONG;
+    p.bytes+=send(p.socket,r);
+  }
+}
+
+// --- snapshots ---
+function encodeSnapshot(p,cur,baseTick,base){
+  const out=Buffer.alloc(14+cur.size*7+(base?base.size*2:0));
+  out[0]=NET.SNAPSHOT;
+  out.writeUInt32LE(tick,1); out.writeUInt32LE(baseTick,5); out.writeUInt32LE(p.lastSeq,9);
+  let off=14,count=0;
+  cur.forEach((q,id)=>{
+    const b=base&&base.get(id);
+    const mask=(!b||b.y!==q.y?1:0)|(!b||b.vy!==q.vy?2:0)|(!b||b.flags!==q.flags?4:0);
+    if(!mask) return;
+    out[off++]=id; out[off++]=mask; count++;
+    if(mask&1){out.writeUInt16LE(q.y,off); off+=2;}
+    if(mask&2){out.writeInt16LE(q.vy,off); off+=2;}
+    if(mask&4) out[off++]=q.flags;
+  });
+  if(base) base.forEach((q,id)=>{
+    if(cur.has(id)) return;
+    out[off++]=id; out[off++]=0x80; count++;
+  });
+  out[13]=count;
+  return out.subarray(0,off);
+}
+function sendSnapshots(){
+  const cur=new Map();
+  players.forEach(p=>cur.set(p.id,{y:Sim.quantizeY(p.plane.y),vy:Sim.quantizeVy(p.plane.vy),flags:(p.hold?FLAG_HOLD:0)|(p.crashed?FLAG_CRASHED:0)}));
+  const dt=SNAPSHOT_EVERY*Sim.STEP;
+  players.forEach(p=>{
+    p.tokens=Math.min(BYTES_PER_SEC,p.tokens+BYTES_PER_SEC*dt);
+    const base=p.history.get(p.acked),msg=encodeSnapshot(p,cur,base?p.acked:0,base);
+    if(msg.length+4>p.tokens){p.dropped++; return;}
+    const n=send(p.socket,msg);
+    p.tokens-=n; p.bytes+=n;
+    p.history.set(tick,cur);
+    for(const t of p.history.keys()){
+      if(p.history.size<=HISTORY) break;
+      p.history.delete(t);
+    }
+  });
+}
+
+function step(){
+  tick++;
+  world.elapsed+=Sim.STEP;
+  players.forEach(p=>{
+    // inputs stamped for a tick we already passed apply now; the client
+    // reconciles against the snapshot
+    while(p.inputs.length&&p.inputs[0].tick<=tick){
+      const i=p.inputs.shift();
+      p.hold=i.hold; p.lastSeq=i.seq;
+    }
+    if(p.crashed) return;
+    Sim.stepPlane(p.plane,p.hold,Sim.STEP);
+    Sim.quantizePlane(p.plane);
+  });
+  Sim.stepObstacles(world,Sim.STEP);
+  players.forEach(p=>{
+    if(!p.crashed&&Sim.planeMaskHits(world,p.plane,masks)){
+      p.crashed=true;
+      console.log(`player ${p.id} crashed at tick ${tick}`);
+    }
+  });
+  if(tick%SNAPSHOT_EVERY===0) sendSnapshots();
+}
+
+const server=http.createServer((req,res)=>{res.writeHead(426); res.end('WebSocket only\n');});
+server.on('upgrade',(req,socket)=>{
+  const key=req.headers['sec-websocket-key'];
+  if(!key){socket.destroy(); return;}
+  const accept=crypto.createHash('sha1').update(key+'258EAFA5-E914-47DA-95CA-C5AB0DC85B11').digest('base64');
+  socket.write('HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n'+
+    `Sec-WebSocket-Accept: ${accept}\r\n\r\n`);
+  socket.setNoDelay(true);
+  const p=join(socket);
+  if(!p) return;
+  socket.on('data',d=>{p.buffer=Buffer.concat([p.buffer,d]); parseFrames(p,m=>onMessage(p,m));});
+  socket.on('close',()=>leave(p));
+  socket.on('error',()=>leave(p));
+});
+
+// step on a fine timer and catch up to wall time so the tick rate holds
+let started=process.hrtime.bigint();
+setInterval(()=>{
+  if(!players.size){started=process.hrtime.bigint(); return;}
+  const due=Number(process.hrtime.bigint()-started)/1e9/Sim.STEP;
+  while(tick<due) step();
+},4);
+setInterval(()=>{
+  players.forEach(p=>{
+    console.log(`player ${p.id}: ${(p.bytes/5).toFixed(0)} B/s sent, ${p.dropped} snapshots over budget`);
+    p.bytes=0; p.dropped=0;
+  });
+},5000);
+
+server.listen(PORT,()=>console.log(`race server on ws://localhost:${PORT}`));
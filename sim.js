@@ -0,0 +1,499 @@
+// Simulation pieces shared by the page, bot.js and server/race-server.js:
+// the fixed step, the logical playfield, plane physics, the seeded RNG and
+// the world state. Everything here must give the same result on every
+// client for a given seed and input.
+(function(root,factory){
+  if(typeof module==='object'&&module.exports) module.exports=factory();
+  else root.MAFSim=factory();
+})(this,function(){
+  const STEP=1/60,FIELD_W=1280,FIELD_H=720;
+  const GRAVITY=20,THRUST=40,MAX_VY=300,SPAWN_INTERVAL=2000;
+  // plane bounds relative to its centre, rider included, for broad-phase tests
+  const PLANE_BOX={left:-41,right:41,top:-94,bottom:6};
+
+  function stepPlane(p,hold,dt){
+    if(hold) p.vy-=THRUST*dt;
+    p.vy+=GRAVITY*dt;
+    p.vy=Math.max(-MAX_VY,Math.min(MAX_VY,p.vy));
+    p.y+=p.vy*dt;
+    if(p.y<0)p.y=0,p.vy=0;
+    if(p.y>FIELD_H-20)p.y=FIELD_H-20,p.vy=0;
+    p.tilt=p.vy/200;
+  }
+
+  // analytic plane motion. Under constant input the acceleration is constant
+  // until vy reaches ±MAX_VY, then the speed is, until the plane reaches the
+  // ceiling or floor and stops there (falling away again from the ceiling if
+  // it isn't holding). planeSegments() writes those phases from (y, vy) as
+  // rows of (start, y, vy, a), the last one open-ended, so the plane's
+  // position any time ahead is one quadratic; advancePlane() uses that to
+  // step by any dt with no integration error. Worlds opt in with w.analytic.
+  const FLOOR=FIELD_H-20,SEG=4,MAX_SEGS=6;
+  function planeSegments(y,vy,hold,out){
+    const a=GRAVITY-(hold?THRUST:0);
+    let t=0,n=0;
+    for(;;){
+      if(y<=0&&vy<0||y>=FLOOR&&vy>0) vy=0;
+      const rest=y<=0&&a<0||y>=FLOOR&&a>0;
+      if(rest) y=y<=0?0:FLOOR;
+      const capped=a>0&&vy>=MAX_VY||a<0&&vy<=-MAX_VY,acc=rest||capped?0:a;
+      const o=n*SEG;
+      out[o]=t; out[o+1]=y; out[o+2]=vy; out[o+3]=acc; n++;
+      if(rest||n===MAX_SEGS) return n;
+      // the phase ends when the speed caps or a bound is reached
+      const tCap=acc?((a>0?MAX_VY:-MAX_VY)-vy)/acc:Infinity;
+      const tCeil=firstRoot(y,vy,acc,0),tFloor=firstRoot(y,vy,acc,FLOOR);
+      if(Math.min(tCeil,tFloor)<=tCap){y=tFloor<tCeil?FLOOR:0; vy=0; t+=Math.min(tCeil,tFloor);}
+      else{y+=vy*tCap+acc*tCap*tCap/2; vy=a>0?MAX_VY:-MAX_VY; t+=tCap;}
+    }
+  }
+  // earliest t>0 with y + vy*t + a*t*t/2 = target, or Infinity
+  function firstRoot(y,vy,a,target){
+    const c=y-target;
+    if(!a){const t=-c/vy; return t>1e-12?t:Infinity;}
+    const d=vy*vy-2*a*c;
+    if(d<0) return Infinity;
+    const s=Math.sqrt(d),t0=(-vy-s)/a,t1=(-vy+s)/a;
+    const lo=Math.min(t0,t1),hi=Math.max(t0,t1);
+    return lo>1e-12?lo:hi>1e-12?hi:Infinity;
+  }
+  function segmentAt(segs,n,t){
+    let k=n-1;
+    while(k>0&&segs[k*SEG]>t) k--;
+    return k*SEG;
+  }
+  const planeSegs=new Float64Array(MAX_SEGS*SEG);
+  function advancePlane(p,hold,dt){
+    const o=segmentAt(planeSegs,planeSegments(p.y,p.vy,hold,planeSegs),dt),d=dt-planeSegs[o],a=planeSegs[o+3];
+    p.y=Math.max(0,Math.min(FLOOR,planeSegs[o+1]+planeSegs[o+2]*d+a*d*d/2));
+    p.vy=planeSegs[o+2]+a*d;
+    p.tilt=p.vy/200;
+  }
+  // earliest t in [t0,t1] at which the segments' y lies in [lo,hi], or -1.
+  // Within a segment y is monotonic on either side of the vertex, so it
+  // enters the band at its start or where it first crosses lo or hi.
+  function firstInBand(segs,n,t0,t1,lo,hi){
+    for(let k=0;k<n;k++){
+      const o=k*SEG,s=segs[o],e=k+1<n?segs[o+SEG]:Infinity;
+      if(e<t0) continue;
+      if(s>t1) break;
+      const from=Math.max(s,t0),to=Math.min(e,t1),a=segs[o+3],d=from-s;
+      const y=segs[o+1]+segs[o+2]*d+a*d*d/2,vy=segs[o+2]+a*d;
+      if(y>=lo&&y<=hi) return from;
+      const t=from+firstRoot(y,vy,a,y<lo?lo:hi);
+      if(t<=to) return t;
+    }
+    return -1;
+  }
+
+  // snapshot quantization: y in 1/65535 of the field, vy in 1/100 px/s.
+  // The server quantizes after every step so predicting clients can too.
+  const Y_SCALE=65535/FIELD_H,VY_SCALE=100;
+  function quantizeY(y){return Math.round(y*Y_SCALE);}
+  function quantizeVy(vy){return Math.round(vy*VY_SCALE);}
+  function quantizePlane(p){
+    p.y=quantizeY(p.y)/Y_SCALE;
+    p.vy=quantizeVy(p.vy)/VY_SCALE;
+    p.tilt=p.vy/200;
+  }
+
+  // mulberry32; the state is a single uint32 so it is cheap to save and
+  // restore. r() is a float in [0,1), r.u32() the raw integer.
+  function rng(seed){
+    const r=()=>r.u32()/4294967296;
+    r.u32=()=>{
+      let t=r.state=(r.state+0x6d2b79f5)>>>0;
+      t=Math.imul(t^(t>>>15),1|t);
+      t=(t+Math.imul(t^(t>>>7),61|t))^t;
+      return (t^(t>>>14))>>>0;
+    };
+    r.state=seed>>>0;
+    return r;
+  }
+
+  // fixed-point mode: plane and obstacles in 16.16 integers, stepped only at
+  // STEP, with per-step constants rounded once here. Every operation is an
+  // integer add, compare, shift or a division truncated back to an integer,
+  // so any engine (or a native port) produces the same bits. The float
+  // columns are refreshed from the integers after each step for drawing.
+  const ONE=65536,STEPS_PER_SEC=60;
+  const FX_GRAVITY=Math.round(GRAVITY*ONE/STEPS_PER_SEC),FX_THRUST=Math.round(THRUST*ONE/STEPS_PER_SEC);
+  const FX_MAX_VY=MAX_VY*ONE,FX_FLOOR=(FIELD_H-20)*ONE,SPAWN_STEPS=SPAWN_INTERVAL*STEPS_PER_SEC/1000;
+  function fxRange(r,range){return Math.floor((r.u32()>>>16)*range/65536);}
+  function stepPlaneFixed(w,hold){
+    const q=w.qplane,p=w.plane;
+    let vy=q[1];
+    if(hold) vy-=FX_THRUST;
+    vy+=FX_GRAVITY;
+    vy=vy<-FX_MAX_VY?-FX_MAX_VY:vy>FX_MAX_VY?FX_MAX_VY:vy;
+    let y=q[0]+Math.trunc(vy/STEPS_PER_SEC);
+    if(y<0)y=0,vy=0;
+    if(y>FX_FLOOR)y=FX_FLOOR,vy=0;
+    q[0]=y; q[1]=vy;
+    p.y=y/ONE; p.vy=vy/ONE; p.tilt=p.vy/200;
+  }
+
+  // obstacle behaviors. Every obstacle drifts left at ospeed; its kind says
+  // what else moves, driven by the per-kind parameter columns op0..op4:
+  //   LINEAR    nothing else
+  //   BOB       y = op0 + op1*sin(op2*t + op3)            (base, amp, rad/s, phase)
+  //   PENDULUM  hangs from the ceiling at x = op0 on a rope of length op1,
+  //             angle op4*sin(op2*t + op3)                (op0 drifts instead of ox)
+  //   GATE      a leaf on the top (op4 0) or bottom (op4 1) edge whose height
+  //             eases between op0 and op1 at op2 rad/s from phase op3
+  // Obstacles are kept grouped by kind (kind k fills kindEnd[k-1]..kindEnd[k]),
+  // so each kind is stepped by its own branch-free loop over contiguous
+  // columns. Fixed-point worlds only spawn LINEAR: Math.sin is not bit-exact
+  // across engines.
+  const LINEAR=0,BOB=1,PENDULUM=2,GATE=3,KINDS=4;
+  const GATE_GAP=150;
+  const BEHAVIORS=[
+    {name:'linear',step:stepLinear},
+    {name:'bob',step:stepBob,spawn(w,i,r){
+      w.op0[i]=w.oy[i]; w.op1[i]=20+r()*Math.min(80,w.oy[i]-20,FIELD_H-w.oy[i]-w.oh[i]-20);
+      w.op2[i]=1+r()*2; w.op3[i]=r()*2*Math.PI;
+    }},
+    {name:'pendulum',step:stepPendulum,spawn(w,i,r){
+      // pivot far enough right that the bob enters at the edge of its swing
+      w.ow[i]=w.oh[i]=40;
+      w.op1[i]=200+r()*(FIELD_H-360); w.op2[i]=1.2+r()*0.8; w.op3[i]=r()*2*Math.PI; w.op4[i]=0.3+r()*0.5;
+      w.op0[i]=w.ox[i]+w.op1[i]*Math.sin(w.op4[i])+w.ow[i];
+    }},
+    {name:'gate',step:stepGate,spawn(w,i,r){
+      // two leaves sharing a phase, never closing tighter than GATE_GAP
+      const max=(FIELD_H-GATE_GAP)/2,omega=0.8+r()*0.8,phase=r()*2*Math.PI;
+      for(let side=0;side<2;side++){
+        const j=side?addObstacle(w,w.ox[i],0,w.ow[i],0,w.ospeed[i],GATE):i;
+        w.op0[j]=40; w.op1[j]=max; w.op2[j]=omega; w.op3[j]=phase; w.op4[j]=side;
+      }
+    }},
+  ];
+  function stepLinear(w,dt,t,i0,i1){
+    const ox=w.ox,sp=w.ospeed;
+    for(let i=i0;i<i1;i++) ox[i]-=sp[i]*dt;
+  }
+  function stepBob(w,dt,t,i0,i1){
+    const {ox,oy,ospeed,op0,op1,op2,op3}=w;
+    for(let i=i0;i<i1;i++){
+      ox[i]-=ospeed[i]*dt;
+      oy[i]=op0[i]+op1[i]*Math.sin(op2[i]*t+op3[i]);
+    }
+  }
+  function stepPendulum(w,dt,t,i0,i1){
+    const {ox,oy,ow,oh,ospeed,op0,op1,op2,op3,op4}=w;
+    for(let i=i0;i<i1;i++){
+      op0[i]-=ospeed[i]*dt;
+      const a=op4[i]*Math.sin(op2[i]*t+op3[i]);
+      ox[i]=op0[i]+op1[i]*Math.sin(a)-ow[i]/2;
+      oy[i]=op1[i]*Math.cos(a)-oh[i]/2;
+    }
+  }
+  function stepGate(w,dt,t,i0,i1){
+    const {ox,oy,oh,ospeed,op0,op1,op2,op3,op4}=w;
+    for(let i=i0;i<i1;i++){
+      ox[i]-=ospeed[i]*dt;
+      const h=op0[i]+(op1[i]-op0[i])*(0.5-0.5*Math.cos(op2[i]*t+op3[i]));
+      oh[i]=h; oy[i]=op4[i]*(FIELD_H-h);
+    }
+  }
+
+  // world state: the plane plus obstacles stored as parallel typed-array
+  // columns, so forking a world for lookahead is a few typed-array copies.
+  // Fixed-point worlds carry integer twins of the columns (q*) as their state.
+  // spawnKinds lists the kinds random spawns pick from; null spawns LINEAR
+  // without drawing a kind, so seeded courses stay what they were. Analytic
+  // worlds (w.analytic) move the plane with advancePlane and keep a
+  // time-of-impact schedule (see scheduleImpacts).
+  const COLUMNS=['ox','oy','ow','oh','ospeed','op0','op1','op2','op3','op4'],FIXED_COLUMNS=['qx','qy','qw','qh','qspeed'];
+  function createWorld(seed,cap=32,fixed=false){
+    const w={elapsed:0,spawnTimer:0,randomSpawns:true,spawnKinds:null,rng:rng(seed),fixed,
+      plane:{x:150,y:FIELD_H/2,vy:0,w:24,h:12,tilt:0},n:0,kindEnd:new Int32Array(KINDS),
+      analytic:false,impacts:new Float64Array(cap*2),impactN:0,impactHold:false,impactDirty:true};
+    COLUMNS.forEach(c=>w[c]=new Float64Array(cap));
+    if(fixed) makeFixed(w);
+    return w;
+  }
+  function makeFixed(w){
+    w.fixed=true;
+    w.qplane=new Int32Array([Math.round(w.plane.y*ONE),Math.round(w.plane.vy*ONE)]);
+    FIXED_COLUMNS.forEach((c,k)=>w[c]=Int32Array.from(w[COLUMNS[k]],v=>Math.round(v*ONE)));
+  }
+  function resetWorld(w,seed){
+    w.elapsed=0; w.spawnTimer=0; w.n=0; w.kindEnd.fill(0); w.rng.state=seed>>>0;
+    w.impactN=0; w.impactDirty=true;
+    const p=w.plane;
+    p.y=FIELD_H/2; p.vy=0; p.tilt=0;
+    if(w.fixed){w.qplane[0]=p.y*ONE; w.qplane[1]=0;}
+  }
+  function growWorld(w,cap){
+    const grow=(c,Type)=>{
+      const a=new Type(cap);
+      a.set(w[c].subarray(0,w.n)); w[c]=a;
+    };
+    COLUMNS.forEach(c=>grow(c,Float64Array));
+    if(w.fixed) FIXED_COLUMNS.forEach(c=>grow(c,Int32Array));
+  }
+  function copyWorld(dst,src){
+    dst.elapsed=src.elapsed; dst.spawnTimer=src.spawnTimer; dst.randomSpawns=src.randomSpawns;
+    dst.spawnKinds=src.spawnKinds; dst.rng.state=src.rng.state;
+    dst.analytic=src.analytic; dst.impactN=0; dst.impactDirty=true;
+    const a=dst.plane,b=src.plane;
+    a.x=b.x; a.y=b.y; a.vy=b.vy; a.tilt=b.tilt;
+    if(src.fixed&&!dst.fixed) makeFixed(dst);
+    dst.fixed=src.fixed;
+    if(dst.ox.length<src.n) growWorld(dst,src.ox.length);
+    COLUMNS.forEach(c=>dst[c].set(src[c].subarray(0,src.n)));
+    if(src.fixed){
+      dst.qplane.set(src.qplane);
+      FIXED_COLUMNS.forEach(c=>dst[c].set(src[c].subarray(0,src.n)));
+    }
+    dst.n=src.n; dst.kindEnd.set(src.kindEnd);
+    return dst;
+  }
+  function moveObstacle(w,from,to){
+    COLUMNS.forEach(c=>w[c][to]=w[c][from]);
+    if(w.fixed) FIXED_COLUMNS.forEach(c=>w[c][to]=w[c][from]);
+  }
+  // inserting into kind k opens a slot at the end of every later kind by
+  // moving its first obstacle to just past its last; obstacle order within
+  // a kind carries no meaning
+  function addObstacle(w,x,y,ow,oh,speed,kind=LINEAR){
+    if(w.n===w.ox.length) growWorld(w,w.n*2);
+    const e=w.kindEnd;
+    for(let k=KINDS-1;k>kind;k--){
+      if(e[k]>e[k-1]) moveObstacle(w,e[k-1],e[k]);
+      e[k]++;
+    }
+    const i=e[kind]++;
+    w.n++; w.impactDirty=true;
+    w.ox[i]=x; w.oy[i]=y; w.ow[i]=ow; w.oh[i]=oh; w.ospeed[i]=speed;
+    w.op0[i]=w.op1[i]=w.op2[i]=w.op3[i]=w.op4[i]=0;
+    if(w.fixed){
+      w.qx[i]=Math.round(x*ONE); w.qy[i]=Math.round(y*ONE); w.qw[i]=Math.round(ow*ONE);
+      w.qh[i]=Math.round(oh*ONE); w.qspeed[i]=Math.round(speed*ONE);
+    }
+    return i;
+  }
+  // the reverse: the last obstacle of each kind from i's on shifts down a slot
+  function removeObstacle(w,i){
+    const e=w.kindEnd;
+    let k=0;
+    while(i>=e[k]) k++;
+    for(;k<KINDS;k++){
+      const last=--e[k];
+      if(last!==i) moveObstacle(w,last,i);
+      i=last;
+    }
+    w.n--;
+  }
+  function kindOf(w,i){
+    let k=0;
+    while(i>=w.kindEnd[k]) k++;
+    return k;
+  }
+  function spawnObstacle(w){
+    const h=40+w.rng()*80;
+    const i=addObstacle(w,FIELD_W+20,w.rng()*(FIELD_H-h-100)+50,30,h,100+w.rng()*50);
+    if(w.spawnKinds) respawnAs(w,i,w.spawnKinds[Math.floor(w.rng()*w.spawnKinds.length)]);
+  }
+  // turn a freshly added LINEAR obstacle into another kind, drawing its
+  // parameters from r (courses pass a stream seeded per record)
+  function respawnAs(w,i,kind,r=w.rng){
+    if(kind===LINEAR) return;
+    const x=w.ox[i],y=w.oy[i],h=w.oh[i],speed=w.ospeed[i];
+    removeObstacle(w,i);
+    const j=addObstacle(w,x,y,30,h,speed,kind);
+    BEHAVIORS[kind].spawn(w,j,r);
+    BEHAVIORS[kind].step(w,0,w.elapsed,w.kindEnd[kind-1],w.kindEnd[kind]);
+  }
+  function spawnObstacleFixed(w){
+    const h=40*ONE+fxRange(w.rng,80*ONE),y=fxRange(w.rng,FIELD_H*ONE-h-100*ONE)+50*ONE;
+    const i=addObstacle(w,0,0,30,0,0);
+    w.qx[i]=(FIELD_W+20)*ONE; w.qy[i]=y; w.qh[i]=h; w.qspeed[i]=100*ONE+fxRange(w.rng,50*ONE);
+    w.ox[i]=w.qx[i]/ONE; w.oy[i]=y/ONE; w.oh[i]=h/ONE; w.ospeed[i]=w.qspeed[i]/ONE;
+  }
+  function stepObstacles(w,dt){
+    if(w.fixed) return stepObstaclesFixed(w);
+    if(w.randomSpawns){
+      w.spawnTimer+=dt*1000;
+      if(w.spawnTimer>SPAWN_INTERVAL){
+        w.spawnTimer=0; spawnObstacle(w);
+      }
+    }
+    const e=w.kindEnd;
+    for(let k=0;k<KINDS;k++) BEHAVIORS[k].step(w,dt,w.elapsed,k?e[k-1]:0,e[k]);
+    // a pendulum's bob can swing back out from behind the edge until the
+    // right end of its swing has left too
+    for(let k=KINDS-1;k>=0;k--){
+      const {ox,ow,op0,op1,op4}=w;
+      for(let i=e[k]-1;i>=(k?e[k-1]:0);i--){
+        const right=k===PENDULUM?op0[i]+op1[i]*Math.sin(op4[i])+ow[i]:ox[i]+ow[i];
+        if(right<0) removeObstacle(w,i);
+      }
+    }
+  }
+  // the fixed spawn timer counts steps instead of milliseconds
+  function stepObstaclesFixed(w){
+    if(w.randomSpawns&&++w.spawnTimer>SPAWN_STEPS){
+      w.spawnTimer=0; spawnObstacleFixed(w);
+    }
+    for(let i=w.n-1;i>=0;i--){
+      w.qx[i]-=Math.trunc(w.qspeed[i]/STEPS_PER_SEC);
+      w.ox[i]=w.qx[i]/ONE;
+      if(w.qx[i]<-w.qw[i]) removeObstacle(w,i);
+    }
+  }
+  // the plane's hit shape, shared by the page and the race server: the hull
+  // triangle HULL plus the rider sprite drawn RIDER_SIZE wide, its feet
+  // RIDER_LIFT above the centre (game.js's drawPlaneShape draws the same).
+  // Each side rasterizes it once per rotation frame, MASK_FRAMES across
+  // ±MASK_TILT, the page on a canvas and the server in
+  // server/plane-masks.js, into row masks packed 32 pixels to a word (bit j
+  // of word k is pixel 32k+j) cropped to their own bounds. A hit test ANDs
+  // those words with the obstacle's span on each overlapping row.
+  const HULL=[-12,-6,12,0,-12,6],RIDER_SIZE=0.08*1024,RIDER_LIFT=12;
+  const MASK_FRAMES=48,MASK_TILT=1.5,MASK_SIZE=208,MASK_ALPHA=128;
+  // one frame from MASK_SIZE² alpha values, alpha[(y*S+x)*stride+offset],
+  // drawn with the plane's centre at the middle
+  function packMask(alpha,stride=1,offset=0){
+    const S=MASK_SIZE,on=(x,y)=>alpha[(y*S+x)*stride+offset]>=MASK_ALPHA;
+    let x0=S,y0=S,x1=-1,y1=-1;
+    for(let y=0;y<S;y++) for(let x=0;x<S;x++) if(on(x,y)){
+      if(x<x0)x0=x; if(x>x1)x1=x; if(y<y0)y0=y; if(y>y1)y1=y;
+    }
+    if(x1<0) return {x:0,y:0,w:0,h:0,words:0,bits:new Uint32Array(0)};
+    const w=x1-x0+1,h=y1-y0+1,words=(w+31)>>>5,bits=new Uint32Array(words*h);
+    for(let y=0;y<h;y++) for(let x=0;x<w;x++)
+      if(on(x+x0,y+y0)) bits[y*words+(x>>>5)]|=1<<(x&31);
+    return {x:x0-S/2,y:y0-S/2,w,h,words,bits};
+  }
+  function maskAngle(f){return -MASK_TILT+2*MASK_TILT*f/(MASK_FRAMES-1);}
+  function maskFrame(masks,tilt){
+    const t=Math.max(-MASK_TILT,Math.min(MASK_TILT,tilt));
+    return masks[Math.round((t+MASK_TILT)/(2*MASK_TILT)*(MASK_FRAMES-1))];
+  }
+  const rectBits=new Uint32Array(MASK_SIZE>>>5);
+  // frame f with its top left at pixel (px,py) against obstacle i
+  function maskHitsObstacle(f,px,py,w,i){
+    const x0=Math.max(0,Math.floor(w.ox[i])-px),x1=Math.min(f.w,Math.ceil(w.ox[i]+w.ow[i])-px);
+    const y0=Math.max(0,Math.floor(w.oy[i])-py),y1=Math.min(f.h,Math.ceil(w.oy[i]+w.oh[i])-py);
+    if(x0>=x1||y0>=y1) return false;
+    const k0=x0>>>5,k1=(x1-1)>>>5;
+    for(let k=k0;k<=k1;k++){
+      const lo=k===k0?x0&31:0,hi=k===k1?((x1-1)&31)+1:32;
+      rectBits[k]=hi-lo===32?0xffffffff:((1<<(hi-lo))-1)<<lo;
+    }
+    for(let y=y0;y<y1;y++){
+      const row=y*f.words;
+      for(let k=k0;k<=k1;k++) if(f.bits[row+k]&rectBits[k]) return true;
+    }
+    return false;
+  }
+  // plane p against every obstacle; the page narrows the candidates with its
+  // grid first
+  function planeMaskHits(w,p,masks){
+    const f=maskFrame(masks,p.tilt),px=Math.round(p.x)+f.x,py=Math.round(p.y)+f.y;
+    for(let i=0;i<w.n;i++) if(maskHitsObstacle(f,px,py,w,i)) return true;
+    return false;
+  }
+
+  // fixed-point worlds always advance by exactly one STEP
+  function stepWorld(w,hold,dt){
+    w.elapsed+=dt;
+    if(w.fixed) stepPlaneFixed(w,hold);
+    else if(w.analytic) advancePlane(w.plane,hold,dt);
+    else stepPlane(w.plane,hold,dt);
+    stepObstacles(w,dt);
+  }
+
+  // time-of-impact schedule for analytic worlds. Every obstacle's x motion is
+  // linear (a pendulum's pivot is, and its bob stays within the swing's
+  // reach), so the time its box can overlap the plane's in x is a closed-form
+  // window, and its whole motion bounds the band it can occupy vertically.
+  // Against the plane's trajectory under the current input (planeSegments),
+  // an obstacle can only be hit from the first time the plane enters that
+  // band within the window until the window closes. The windows are rebuilt
+  // when the input changes or an obstacle is added, and collision tests are
+  // only needed while one is open. The plane is bounded by a circle of
+  // TOI_RADIUS, which holds the rider box at any tilt.
+  const TOI_RADIUS=Math.ceil(Math.hypot(PLANE_BOX.right,PLANE_BOX.top))+1;
+  const impactSegs=new Float64Array(MAX_SEGS*SEG);
+  function scheduleImpacts(w,hold){
+    const p=w.plane,n=planeSegments(p.y,p.vy,hold,impactSegs),e=w.kindEnd;
+    const {ox,oy,ow,oh,ospeed,op0,op1,op4}=w,near=p.x-TOI_RADIUS,far=p.x+TOI_RADIUS;
+    if(w.impacts.length<w.n*2) w.impacts=new Float64Array(w.ox.length*2);
+    let m=0;
+    for(let k=0;k<KINDS;k++) for(let i=k?e[k-1]:0;i<e[k];i++){
+      let left=ox[i],right=ox[i]+ow[i],top=oy[i],bottom=oy[i]+oh[i];
+      if(k===BOB){top=op0[i]-op1[i]; bottom=op0[i]+op1[i]+oh[i];}
+      else if(k===PENDULUM){
+        const reach=op1[i]*Math.sin(op4[i])+ow[i]/2;
+        left=op0[i]-reach; right=op0[i]+reach;
+        top=op1[i]*Math.cos(op4[i])-oh[i]/2; bottom=op1[i]+oh[i]/2;
+      }else if(k===GATE){top=op4[i]*(FIELD_H-op1[i]); bottom=top+op1[i];}
+      const v=ospeed[i];
+      let enter,exit;
+      if(v>0){enter=(left-far)/v; exit=(right-near)/v;}
+      else if(left<far&&right>near){enter=0; exit=Infinity;}
+      else continue;
+      if(exit<0) continue;
+      const t=firstInBand(impactSegs,n,Math.max(0,enter),exit,top-TOI_RADIUS,bottom+TOI_RADIUS);
+      if(t<0) continue;
+      w.impacts[m++]=w.elapsed+t; w.impacts[m++]=w.elapsed+exit;
+    }
+    w.impactN=m/2; w.impactHold=hold; w.impactDirty=false;
+  }
+  // call after each step, and before sizing the next, with the current input
+  function updateImpacts(w,hold){
+    if(w.impactDirty||hold!==w.impactHold) scheduleImpacts(w,hold);
+  }
+  function impactOpen(w){
+    const a=w.impacts,t=w.elapsed;
+    for(let j=0;j<w.impactN*2;j+=2) if(a[j]<=t&&t<=a[j+1]) return true;
+    return false;
+  }
+  // how far an analytic world can step at once: STEP while a window is open,
+  // otherwise up to the next window opening or random spawn, so both land
+  // on a step boundary
+  function analyticStep(w,dt){
+    if(impactOpen(w)) return Math.min(dt,STEP);
+    const a=w.impacts,t=w.elapsed;
+    let h=dt;
+    for(let j=0;j<w.impactN*2;j+=2) if(a[j]>t) h=Math.min(h,a[j]-t);
+    if(w.randomSpawns) h=Math.min(h,(SPAWN_INTERVAL-w.spawnTimer)/1000+1e-6);
+    return Math.max(h,1e-6);
+  }
+
+  // FNV-1a over the state that decides the future: RNG, spawn timer, plane
+  // and obstacles (the integer state for fixed worlds, float bits otherwise)
+  const hashView=new DataView(new ArrayBuffer(8));
+  function hashWorld(w,h=0x811c9dc5){
+    const mix=v=>{
+      for(let k=0;k<4;k++){h^=(v>>>(k*8))&0xff; h=Math.imul(h,0x01000193);}
+    };
+    const mixFloat=v=>{
+      hashView.setFloat64(0,v);
+      mix(hashView.getUint32(0)); mix(hashView.getUint32(4));
+    };
+    mix(w.rng.state); mix(w.spawnTimer|0); mix(w.n);
+    if(w.fixed){
+      mix(w.qplane[0]); mix(w.qplane[1]);
+      for(let i=0;i<w.n;i++){mix(w.qx[i]); mix(w.qy[i]); mix(w.qw[i]); mix(w.qh[i]); mix(w.qspeed[i]);}
+    }else{
+      mixFloat(w.spawnTimer); mixFloat(w.plane.y); mixFloat(w.plane.vy);
+      for(let k=0;k<KINDS;k++) mix(w.kindEnd[k]);
+      for(let i=0;i<w.n;i++){
+        mixFloat(w.ox[i]); mixFloat(w.oy[i]); mixFloat(w.oh[i]); mixFloat(w.ospeed[i]);
+        mixFloat(w.op0[i]); mixFloat(w.op1[i]); mixFloat(w.op2[i]); mixFloat(w.op3[i]); mixFloat(w.op4[i]);
+      }
+    }
+    return h>>>0;
+  }
+
+  return {STEP,FIELD_W,FIELD_H,GRAVITY,THRUST,MAX_VY,SPAWN_INTERVAL,PLANE_BOX,Y_SCALE,VY_SCALE,
+    LINEAR,BOB,PENDULUM,GATE,KINDS,BEHAVIORS,
+    stepPlane,stepPlaneFixed,planeSegments,advancePlane,quantizeY,quantizeVy,quantizePlane,rng,
+    createWorld,resetWorld,copyWorld,addObstacle,removeObstacle,kindOf,respawnAs,stepObstacles,stepWorld,
+    HULL,RIDER_SIZE,RIDER_LIFT,MASK_FRAMES,MASK_TILT,MASK_SIZE,packMask,maskAngle,maskFrame,maskHitsObstacle,planeMaskHits,
+    updateImpacts,impactOpen,analyticStep,hashWorld};
+});
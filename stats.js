@@ -0,0 +1,126 @@
+// Per-run statistics in constant memory, updated as the run goes so the
+// summary is ready the moment it ends.
+//
+// Quantiles come from a merging t-digest: values collect in a fixed buffer
+// and are folded into at most ~pi*compression/2 weighted centroids whenever
+// it fills, with centroids kept small near the tails (the k1 scale
+// function), so p1/p99 stay accurate however long the run. Samples may
+// carry a weight (the sim time they stand for, when steps vary in length);
+// quantiles are then over total weight. Everything lives in typed arrays
+// allocated once.
+(function(root,factory){
+  if(typeof module==='object'&&module.exports) module.exports=factory();
+  else root.MAFStats=factory();
+})(this,function(){
+  const NEAR_MISS=40; // px of plane-box clearance that counts as a near miss
+
+  function createDigest(compression=100,bufferSize=256){
+    const cap=Math.ceil(Math.PI*compression/2)+8;
+    let mean=new Float64Array(cap),weight=new Float64Array(cap);
+    let outMean=new Float64Array(cap),outWeight=new Float64Array(cap);
+    const buf=new Float64Array(bufferSize),bufWeight=new Float64Array(bufferSize),order=new Int32Array(bufferSize);
+    let n=0,nb=0,total=0,pending=0,min=Infinity,max=-Infinity;
+    const byValue=(a,b)=>buf[a]-buf[b];
+    // largest quantile a centroid starting at q may reach: k(q)+1 in k1 units
+    const qLimit=q=>{
+      const k=compression/(2*Math.PI)*Math.asin(2*q-1)+1;
+      return k>=compression/4?1:(Math.sin(k*2*Math.PI/compression)+1)/2;
+    };
+    function merge(){
+      if(!nb) return;
+      for(let k=0;k<nb;k++) order[k]=k;
+      const sorted=order.subarray(0,nb).sort(byValue);
+      const all=total+pending;
+      let i=0,j=0,m=0,before=0,limit=qLimit(0)*all,cm=0,cw=0;
+      while(i<n||j<nb){
+        let x,w;
+        if(j>=nb||(i<n&&mean[i]<=buf[sorted[j]])){x=mean[i]; w=weight[i++];}
+        else{x=buf[sorted[j]]; w=bufWeight[sorted[j++]];}
+        if(cw&&before+cw+w<=limit){cw+=w; cm+=(x-cm)*w/cw; continue;}
+        if(cw){
+          outMean[m]=cm; outWeight[m++]=cw; before+=cw;
+          limit=qLimit(before/all)*all;
+        }
+        cm=x; cw=w;
+      }
+      outMean[m]=cm; outWeight[m++]=cw;
+      [mean,outMean]=[outMean,mean]; [weight,outWeight]=[outWeight,weight];
+      n=m; nb=0; pending=0; total=all;
+    }
+    return {
+      add(x,w=1){
+        if(!(w>0)) return;
+        if(x<min) min=x;
+        if(x>max) max=x;
+        buf[nb]=x; bufWeight[nb++]=w; pending+=w;
+        if(nb===bufferSize) merge();
+      },
+      quantile(q){
+        merge();
+        if(!total) return NaN;
+        if(n===1) return mean[0];
+        // interpolate between centroid centres, and out to min/max at the ends
+        const target=q*total;
+        let cum=0;
+        for(let i=0;i<n;i++){
+          const mid=cum+weight[i]/2;
+          if(target<mid){
+            if(i===0) return min+(mean[0]-min)*(mid?target/mid:0);
+            const prev=cum-weight[i-1]/2;
+            return mean[i-1]+(mean[i]-mean[i-1])*(target-prev)/(mid-prev);
+          }
+          cum+=weight[i];
+        }
+        const last=total-weight[n-1]/2;
+        return mean[n-1]+(max-mean[n-1])*(target-last)/(total-last||1);
+      },
+      get count(){return total+pending;}, // total weight
+      get centroids(){merge(); return n;},
+      get min(){return min;},
+      get max(){return max;},
+      reset(){n=nb=total=pending=0; min=Infinity; max=-Infinity;},
+    };
+  }
+
+  // one run: call step() every sim step and frame() every rendered frame
+  function createRunStats(){
+    const altitude=createDigest(),nearMiss=createDigest(50),frameMs=createDigest();
+    const s={steps:0,time:0,held:0,presses:0,nearMisses:0,wasHeld:false,inMiss:false,missMin:0};
+    return {
+      // altitude in px above the floor, hold state and the plane box's
+      // clearance to the nearest obstacle after a step of dt seconds (any
+      // unit, as long as it is the same every call); altitude and hold
+      // duty are weighted by it. A near miss is one dip below NEAR_MISS,
+      // recorded at its closest.
+      step(altitudePx,hold,clearance,dt=1){
+        s.steps++; s.time+=dt;
+        altitude.add(altitudePx,dt);
+        if(hold){s.held+=dt; if(!s.wasHeld) s.presses++;}
+        s.wasHeld=hold;
+        if(clearance<NEAR_MISS){
+          if(!s.inMiss){s.inMiss=true; s.missMin=clearance;}
+          else if(clearance<s.missMin) s.missMin=clearance;
+        }else if(s.inMiss){
+          s.inMiss=false; s.nearMisses++; nearMiss.add(s.missMin);
+        }
+      },
+      frame(ms){frameMs.add(ms);},
+      reset(){
+        altitude.reset(); nearMiss.reset(); frameMs.reset();
+        Object.assign(s,{steps:0,time:0,held:0,presses:0,nearMisses:0,wasHeld:false,inMiss:false,missMin:0});
+      },
+      summary(){
+        return {
+          steps:s.steps,
+          altitude:{p10:altitude.quantile(0.1),p50:altitude.quantile(0.5),p90:altitude.quantile(0.9),
+            min:altitude.min,max:altitude.max},
+          hold:{duty:s.time?s.held/s.time:0,presses:s.presses},
+          nearMiss:{count:s.nearMisses,closest:nearMiss.min,p50:nearMiss.quantile(0.5)},
+          frameMs:{p50:frameMs.quantile(0.5),p95:frameMs.quantile(0.95),p99:frameMs.quantile(0.99),max:frameMs.max},
+        };
+      },
+    };
+  }
+
+  return {NEAR_MISS,createDigest,createRunStats};
+});
@@ -0,0 +1,27 @@
+// Continuous thrust rumble: low-passed noise plus a wobbling low tone, faded
+// in and out per sample toward the 'level' parameter so holding and
+// releasing never clicks.
+class ThrustProcessor extends AudioWorkletProcessor{
+  static get parameterDescriptors(){
+    return [{name:'level',defaultValue:0,minValue:0,maxValue:1,automationRate:'k-rate'}];
+  }
+  constructor(){
+    super();
+    this.gain=0; this.lp=0; this.phase=0; this.seed=22222;
+  }
+  process(inputs,outputs,parameters){
+    const out=outputs[0],target=parameters.level[0],ch=out[0];
+    for(let i=0;i<ch.length;i++){
+      this.gain+=(target-this.gain)*0.002;
+      // xorshift noise, one-pole low-pass
+      this.seed^=this.seed<<13; this.seed^=this.seed>>>17; this.seed^=this.seed<<5;
+      this.lp+=((this.seed>>>0)/4294967296*2-1-this.lp)*0.05;
+      this.phase+=(55+this.gain*25)/sampleRate;
+      if(this.phase>1) this.phase-=1;
+      ch[i]=(this.lp*0.8+Math.sin(this.phase*2*Math.PI)*0.2)*this.gain*0.5;
+    }
+    for(let c=1;c<out.length;c++) out[c].set(ch);
+    return true;
+  }
+}
+registerProcessor('thrust',ThrustProcessor);
@@ -0,0 +1,23 @@
+// Flies seeded random courses with the autopilot to check they are passable.
+//   node tools/bot-run.js [seed] [minutes] [runs]
+// The search budget is unlimited here so results depend only on the seed.
+const Sim=require('../sim.js'),Bot=require('../bot.js');
+
+const seed=+(process.argv[2]||1),minutes=+(process.argv[3]||5),runs=+(process.argv[4]||1);
+for(let r=0;r<runs;r++){
+  const world=Sim.createWorld(seed+r),bot=Bot.createBot({budgetMs:Infinity});
+  const steps=Math.round(minutes*60/Sim.STEP);
+  let hits=0,minClear=Infinity,sumClear=0,inHit=false,holds=0;
+  const t0=Date.now();
+  for(let i=0;i<steps;i++){
+    const hold=bot.think(world);
+    Sim.stepWorld(world,hold,Sim.STEP);
+    const c=Bot.clearance(world);
+    if(!c&&!inHit) hits++;
+    inHit=!c; holds+=hold;
+    minClear=Math.min(minClear,c); sumClear+=c;
+  }
+  const ms=(Date.now()-t0)/steps;
+  console.log(`seed ${seed+r}: ${hits} hits, clearance min ${minClear.toFixed(1)} mean ${(sumClear/steps).toFixed(1)}, `+
+    `hold ${(holds/steps*100).toFixed(0)}%, ${ms.toFixed(3)} ms/step`);
+}
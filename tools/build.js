@@ -0,0 +1,140 @@
+// Production build into dist/:
+//   node tools/build.js [outDir]
+//
+// index.html comes out as one file: its scripts (sim.js, bot.js, audio.js,
+// stats.js, game.js) are inlined into it, every script is minified, and
+// the rider sprite (drawn from the first frame) is inlined as a data URI,
+// downscaled to its CRITICAL size. So a cold start needs only the page
+// itself before the first frame. Everything else the page loads later
+// (the victory image, workers, the audio worklet) is copied under a
+// content-hashed name, images downscaled to the size they are drawn at, and
+// its references are rewritten. manifest.json lists those files, the page
+// prefetches the ones a normal run needs, and _headers (Netlify /
+// Cloudflare Pages format) marks hashed files immutable so repeat loads
+// only revalidate the page.
+const fs=require('fs'),path=require('path'),crypto=require('crypto');
+const {decodePng,encodePng,downscale}=require('./png.js');
+
+const root=path.join(__dirname,'..'),out=path.resolve(process.argv[2]||path.join(root,'dist'));
+const INLINE_SCRIPTS=['sim.js','bot.js','audio.js','stats.js','game.js'];
+const CRITICAL={'chibi-aaron.png':256};
+// hashed assets; prefetch marks the ones a plain run uses, px downscales an
+// image to that many pixels on its longer side (the victory image is drawn
+// at most 0.6*FIELD_H, about 430 field px)
+const ASSETS={'hug.png':{prefetch:true,px:512},'thrust-worklet.js':{prefetch:true},
+  'course-worker.js':{},'recorder-worker.js':{},'watchdog-worker.js':{}};
+
+const read=f=>fs.readFileSync(path.join(root,f));
+
+// --- minifier -------------------------------------------------------------
+// Drops comments and indentation and collapses whitespace, keeping one
+// newline wherever the source had one so automatic semicolon insertion
+// still sees the same statements. Strings, template literals and regex
+// literals pass through untouched.
+const WORD=/[\w$\u0080-\uffff]/;
+const REGEX_AFTER=/(^|[(,=:[!&|?{};+\-*%<>~^]|\b(?:return|typeof|case|do|else|in|of|new|delete|void|throw|yield|await))$/;
+function minify(src){
+  let out='',i=0,pending='';
+  const braces=[]; // template literal nesting: true for a `${` brace
+  const emit=s=>{
+    if(pending){
+      if(pending==='\n'&&out&&!out.endsWith('\n')) out+='\n';
+      else if(pending===' '&&WORD.test(out[out.length-1]||'')&&WORD.test(s[0])) out+=' ';
+      // keep `a - -b`, `a + +b` apart
+      else if(pending===' '&&/[+-]$/.test(out)&&s[0]===out[out.length-1]) out+=' ';
+      pending='';
+    }
+    out+=s;
+  };
+  const template=()=>{ // i is just past a ` or the } closing ${
+    let s='';
+    for(;i<src.length;i++){
+      const c=src[i];
+      if(c==='\\'){s+=c+src[++i]; continue;}
+      if(c==='`'){i++; emit(s+'`'); return;}
+      if(c==='$'&&src[i+1]==='{'){i+=2; braces.push(true); emit(s+'${'); return;}
+      s+=c;
+    }
+    throw new Error('unterminated template literal');
+  };
+  while(i<src.length){
+    const c=src[i];
+    if(c==='\n'||c==='\r'){pending='\n'; i++; continue;}
+    if(/\s/.test(c)){if(pending!=='\n') pending=' '; i++; continue;}
+    if(c==='/'&&src[i+1]==='/'){while(i<src.length&&src[i]!=='\n') i++; continue;}
+    if(c==='/'&&src[i+1]==='*'){
+      const end=src.indexOf('*/',i+2);
+      if(src.slice(i,end).includes('\n')) pending='\n'; else if(pending!=='\n') pending=' ';
+      i=end+2; continue;
+    }
+    if(c==='"'||c==="'"){
+      let j=i+1;
+      while(src[j]!==c){if(src[j]==='\\') j++; j++;}
+      emit(src.slice(i,j+1)); i=j+1; continue;
+    }
+    if(c==='`'){i++; emit('`'); template(); continue;}
+    if(c==='{'){braces.push(false); emit(c); i++; continue;}
+    if(c==='}'){
+      i++;
+      if(braces.pop()){emit('}'); template();} else emit('}');
+      continue;
+    }
+    if(c==='/'&&REGEX_AFTER.test(out.trimEnd())){
+      let j=i+1,cls=false;
+      for(;src[j]!=='/'||cls;j++){
+        if(src[j]==='\\') j++;
+        else if(src[j]==='[') cls=true;
+        else if(src[j]===']') cls=false;
+      }
+      j++;
+      while(WORD.test(src[j]||'')) j++;
+      emit(src.slice(i,j)); i=j; continue;
+    }
+    let j=i+1;
+    if(WORD.test(c)) while(j<src.length&&WORD.test(src[j])) j++;
+    emit(src.slice(i,j)); i=j;
+  }
+  return out.trim();
+}
+
+// --- build -----------------------------------------------------------------
+fs.rmSync(out,{recursive:true,force:true});
+fs.mkdirSync(out,{recursive:true});
+const manifest={assets:{},inlined:{}};
+const names={};
+for(const [file,opts] of Object.entries(ASSETS)){
+  let data=read(file);
+  if(file.endsWith('.js')) data=Buffer.from(minify(data.toString('utf8'))+'\n');
+  if(opts.px) data=encodePng(downscale(decodePng(data),opts.px));
+  const hash=crypto.createHash('sha256').update(data).digest('hex').slice(0,10);
+  const ext=path.extname(file),name=path.basename(file,ext)+'.'+hash+ext;
+  fs.writeFileSync(path.join(out,name),data);
+  names[file]=name;
+  manifest.assets[file]={file:name,bytes:data.length,prefetch:!!opts.prefetch,...opts.px&&{px:opts.px}};
+}
+for(const [file,size] of Object.entries(CRITICAL)){
+  const png=encodePng(downscale(decodePng(read(file)),size));
+  names[file]='data:image/png;base64,'+png.toString('base64');
+  manifest.inlined[file]={px:size,bytes:png.length};
+}
+// asset references appear in the source as quoted file names
+const rewrite=js=>js.replace(/(["'])([\w-]+\.(?:png|js))\1/g,(m,q,f)=>f in names?q+names[f]+q:m);
+
+let html=read('index.html').toString('utf8');
+html=html.replace(/<script(?: src="([^"]+)")?>([\s\S]*?)<\/script>/g,(m,f,js)=>{
+  if(f&&!INLINE_SCRIPTS.includes(f)) throw new Error('script not inlined: '+f);
+  return '<script>'+rewrite(minify(f?read(f).toString('utf8'):js))+'</script>';
+}).replace(/<style>([\s\S]*?)<\/style>/,(m,css)=>'<style>'+css.replace(/\s*\n\s*/g,'')+'</style>')
+  .replace(/\n\s*(?=<)/g,'');
+const links=Object.values(manifest.assets).filter(a=>a.prefetch).map(a=>`<link rel="prefetch" href="${a.file}">`).join('');
+html=html.replace('</head>',links+'</head>');
+fs.writeFileSync(path.join(out,'index.html'),html);
+manifest.page={file:'index.html',bytes:Buffer.byteLength(html)};
+fs.writeFileSync(path.join(out,'manifest.json'),JSON.stringify(manifest,null,2)+'\n');
+fs.writeFileSync(path.join(out,'_headers'),[
+  ...['/','/index.html','/manifest.json'].flatMap(p=>[p,'  Cache-Control: no-cache']),
+  ...Object.values(manifest.assets).flatMap(a=>['/'+a.file,'  Cache-Control: public, max-age=31536000, immutable']),
+  ''].join('\n'));
+
+console.log(`index.html ${manifest.page.bytes} bytes (sprite tier inlined: ${Object.values(manifest.inlined).map(a=>a.bytes).join(', ')} bytes)`);
+for(const [f,a] of Object.entries(manifest.assets)) console.log(`${f} -> ${a.file} ${a.bytes} bytes`);
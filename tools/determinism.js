@@ -0,0 +1,39 @@
+// Cross-engine determinism check for the fixed-point simulation.
+//
+// Flies a seeded world with a scripted input pattern, hashes the state after
+// every step and folds the hashes into a chain, printing a checkpoint every
+// CHECKPOINT steps. The final chain must equal EXPECTED on every engine:
+//   node tools/determinism.js            V8
+//   js tools/determinism.js              SpiderMonkey shell (run from the repo root)
+//   d8 tools/determinism.js              V8 shell (run from the repo root)
+// Pass --steps to print every per-step hash so two engines can be diffed
+// to the first step that disagrees; --float runs the float path instead,
+// which is reported but not checked.
+(function(shellArgs){
+  const isNode=typeof require==='function'&&typeof module==='object';
+  const args=isNode?process.argv.slice(2):typeof scriptArgs!=='undefined'?scriptArgs:Array.from(shellArgs);
+  if(!isNode&&typeof MAFSim==='undefined') load('sim.js');
+  const Sim=isNode?require('../sim.js'):MAFSim;
+  const out=typeof console!=='undefined'?(...a)=>console.log(...a):print;
+
+  const SEED=12000,STEPS=36000,CHECKPOINT=3600,EXPECTED=0x33df51b0;
+  const fixed=args.indexOf('--float')<0,everyStep=args.indexOf('--steps')>=0;
+
+  const world=Sim.createWorld(SEED,32,fixed),input=Sim.rng(SEED^0x5eed);
+  let hold=false,chain=0x811c9dc5;
+  for(let i=1;i<=STEPS;i++){
+    // hold for runs of 0.2-1 s at a time, the way a player taps
+    if(input.u32()%40===0) hold=!hold;
+    Sim.stepWorld(world,hold,Sim.STEP);
+    chain=Sim.hashWorld(world,chain);
+    if(everyStep) out(i+' '+Sim.hashWorld(world).toString(16));
+    else if(i%CHECKPOINT===0) out(`step ${i}: ${chain.toString(16).padStart(8,'0')} (${world.n} obstacles)`);
+  }
+  const hex=chain.toString(16).padStart(8,'0');
+  if(!fixed){out('float path: '+hex+' (not checked)'); return;}
+  if(chain===EXPECTED) out('fixed path: '+hex+' ok');
+  else{
+    out('fixed path: '+hex+' expected '+EXPECTED.toString(16).padStart(8,'0'));
+    if(isNode) process.exitCode=1;
+  }
+})(typeof arguments!=='undefined'?arguments:[]);
@@ -0,0 +1,71 @@
+// Opens a page of this repo in headless Chrome and prints the JSON it leaves
+// in window.MAF_RESULT, exiting non-zero when the result has pass:false.
+//   node tools/headless.js 'index.html?harness' [timeout seconds]
+//   node tools/headless.js 'bench.html?counts=100,1000'
+// Needs Node 22+ (or Node 20 with --experimental-websocket) and Chrome or
+// Chromium; set CHROME to pick the binary. The repo is served over HTTP
+// from a throwaway local server so workers and image reads behave as
+// they do when deployed.
+const http=require('http'),fs=require('fs'),path=require('path'),os=require('os');
+const {spawn}=require('child_process');
+
+const page=process.argv[2]||'index.html?harness',timeout=(+process.argv[3]||300)*1000;
+const root=path.join(__dirname,'..');
+const TYPES={'.html':'text/html','.js':'text/javascript','.png':'image/png','.json':'application/json',
+  '.mafc':'application/octet-stream'};
+
+function fail(msg){console.error(msg); process.exit(2);}
+if(typeof WebSocket==='undefined') fail('needs a global WebSocket: Node 22+, or node --experimental-websocket');
+
+const server=http.createServer((req,res)=>{
+  const file=path.join(root,decodeURIComponent(new URL(req.url,'http://x').pathname));
+  if(!file.startsWith(root)||!fs.existsSync(file)||fs.statSync(file).isDirectory()){res.writeHead(404); res.end(); return;}
+  res.writeHead(200,{'Content-Type':TYPES[path.extname(file)]||'application/octet-stream'});
+  fs.createReadStream(file).pipe(res);
+});
+
+server.listen(0,'127.0.0.1',()=>{
+  const url=`http://127.0.0.1:${server.address().port}/${page}`;
+  const chrome=process.env.CHROME||['chromium','chromium-browser','google-chrome','google-chrome-stable']
+    .find(c=>process.env.PATH.split(path.delimiter).some(d=>fs.existsSync(path.join(d,c))));
+  if(!chrome) fail('no Chrome or Chromium found; set CHROME');
+  const profile=fs.mkdtempSync(path.join(os.tmpdir(),'maf-'));
+  const proc=spawn(chrome,['--headless=new','--remote-debugging-port=0','--user-data-dir='+profile,
+    '--autoplay-policy=no-user-gesture-required','--no-first-run','about:blank']);
+  const done=code=>{
+    proc.kill(); server.close();
+    fs.rmSync(profile,{recursive:true,force:true});
+    process.exit(code);
+  };
+  setTimeout(()=>{console.error('timed out waiting for MAF_RESULT'); done(2);},timeout);
+  let err='';
+  proc.stderr.on('data',async d=>{
+    err+=d;
+    const m=/DevTools listening on (ws:\/\/[^\s]+)/.exec(err);
+    if(!m||proc.started) return;
+    proc.started=true;
+    const port=new URL(m[1]).port;
+    const target=await (await fetch(`http://127.0.0.1:${port}/json/new?${encodeURIComponent(url)}`,{method:'PUT'})).json();
+    const ws=new WebSocket(target.webSocketDebuggerUrl);
+    let id=0;
+    const pending=new Map();
+    const call=(method,params)=>new Promise(r=>{pending.set(++id,r); ws.send(JSON.stringify({id,method,params}));});
+    ws.onmessage=e=>{
+      const msg=JSON.parse(e.data);
+      if(msg.id&&pending.has(msg.id)){pending.get(msg.id)(msg.result); pending.delete(msg.id);}
+    };
+    ws.onopen=async()=>{
+      for(;;){
+        const r=await call('Runtime.evaluate',{expression:'window.MAF_RESULT&&JSON.stringify(window.MAF_RESULT)',returnByValue:true});
+        const v=r&&r.result&&r.result.value;
+        if(v){
+          console.log(JSON.stringify(JSON.parse(v),null,2));
+          done(JSON.parse(v).pass===false?1:0);
+          return;
+        }
+        await new Promise(r=>setTimeout(r,500));
+      }
+    };
+  });
+  proc.on('exit',code=>{if(!proc.started) fail('browser exited ('+code+'):\n'+err);});
+});
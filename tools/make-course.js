@@ -0,0 +1,45 @@
+// Writes a seeded random course in the .mafc format read by course-worker.js.
+//   node tools/make-course.js [seed] [out.mafc] [totalKm] [kinds]
+// kinds is a comma-separated list of behaviors (linear,bob,pendulum,gate)
+// each record picks from, with its param seeding the behavior's parameters;
+// the default, linear, writes the same course as before for a given seed.
+const fs=require('fs');
+const Sim=require('../sim.js');
+
+const seed=+(process.argv[2]||1),out=process.argv[3]||'course.mafc',totalKm=+(process.argv[4]||12000);
+const CHUNK_KM=100,RECORD=12;
+const kinds=(process.argv[5]||'linear').split(',').map(name=>{
+  const k=Sim.BEHAVIORS.findIndex(b=>b.name===name);
+  if(k<0) throw new Error('unknown kind '+name+' (expected '+Sim.BEHAVIORS.map(b=>b.name).join(', ')+')');
+  return k;
+});
+
+const rand=Sim.rng(seed);
+
+const parts=[],header=Buffer.alloc(16);
+header.write('MAFC',0,'latin1');
+header.writeUInt16LE(1,4); header.writeUInt16LE(RECORD,6);
+header.writeUInt16LE(CHUNK_KM,8); header.writeUInt32LE(totalKm,12);
+parts.push(header);
+
+let km=5;
+for(let index=0;index*CHUNK_KM<totalKm;index++){
+  const records=[],end=Math.min(totalKm,(index+1)*CHUNK_KM);
+  for(;km<end;km+=2.5+rand()*2){
+    const h=0.08+rand()*0.15,r=Buffer.alloc(RECORD);
+    r.writeUInt16LE(Math.round((km-index*CHUNK_KM)*100),0);
+    r.writeUInt16LE(Math.round((0.07+rand()*(0.86-h))*65535),2);
+    r.writeUInt16LE(Math.round(h*65535),4);
+    r.writeUInt16LE(Math.round(100+rand()*50+km/200),6);
+    if(kinds.length>1||kinds[0]!==Sim.LINEAR){
+      r.writeUInt8(kinds[Math.floor(rand()*kinds.length)],8);
+      r.writeUInt16LE(rand.u32()&0xffff,10);
+    }
+    records.push(r);
+  }
+  const chunk=Buffer.alloc(8);
+  chunk.writeUInt32LE(index,0); chunk.writeUInt16LE(records.length,4);
+  parts.push(chunk,...records);
+}
+fs.writeFileSync(out,Buffer.concat(parts));
+console.log(`wrote ${out}: ${totalKm} km, seed ${seed}, kinds ${kinds.map(k=>Sim.BEHAVIORS[k].name).join(',')}`);
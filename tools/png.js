@@ -0,0 +1,90 @@
+// Just enough PNG for our own sprites, shared by tools/build.js and
+// server/plane-masks.js: decode 8-bit RGB or RGBA (not interlaced) into
+// RGBA pixels, encode RGBA, and box-filter downscale.
+const zlib=require('zlib');
+
+const CRC=new Int32Array(256).map((_,n)=>{for(let k=0;k<8;k++) n=n&1?0xedb88320^(n>>>1):n>>>1; return n;});
+function crc32(buf){
+  let c=-1;
+  for(const b of buf) c=CRC[(c^b)&255]^(c>>>8);
+  return (c^-1)>>>0;
+}
+function paeth(a,b,c){
+  const p=a+b-c,pa=Math.abs(p-a),pb=Math.abs(p-b),pc=Math.abs(p-c);
+  return pa<=pb&&pa<=pc?a:pb<=pc?b:c;
+}
+function decodePng(buf){
+  let w,h,bpp,idat=[];
+  for(let o=8;o<buf.length;){
+    const len=buf.readUInt32BE(o),type=buf.toString('latin1',o+4,o+8),data=buf.subarray(o+8,o+8+len);
+    if(type==='IHDR'){
+      w=data.readUInt32BE(0); h=data.readUInt32BE(4);
+      if(data[8]!==8||(data[9]!==2&&data[9]!==6)||data[12]) throw new Error('unsupported PNG format');
+      bpp=data[9]===6?4:3;
+    }
+    else if(type==='IDAT') idat.push(data);
+    o+=12+len;
+  }
+  const raw=zlib.inflateSync(Buffer.concat(idat)),stride=w*bpp,px=new Uint8Array(w*h*4);
+  let prev=new Uint8Array(stride);
+  for(let y=0;y<h;y++){
+    const f=raw[y*(stride+1)],row=raw.subarray(y*(stride+1)+1,(y+1)*(stride+1)),cur=new Uint8Array(stride);
+    for(let x=0;x<stride;x++){
+      const a=x>=bpp?cur[x-bpp]:0,b=prev[x],c=x>=bpp?prev[x-bpp]:0;
+      cur[x]=row[x]+(f===1?a:f===2?b:f===3?(a+b)>>1:f===4?paeth(a,b,c):0);
+    }
+    for(let x=0;x<w;x++){
+      const d=(y*w+x)*4;
+      px[d]=cur[x*bpp]; px[d+1]=cur[x*bpp+1]; px[d+2]=cur[x*bpp+2]; px[d+3]=bpp===4?cur[x*bpp+3]:255;
+    }
+    prev=cur;
+  }
+  return {w,h,px};
+}
+function encodePng({w,h,px}){
+  const stride=w*4,raw=Buffer.alloc(h*(stride+1));
+  // per row, the filter with the smallest sum of absolute residuals
+  for(let y=0;y<h;y++){
+    let best=null,bestSum=Infinity;
+    for(let f=0;f<5;f++){
+      const row=Buffer.alloc(stride+1);
+      let sum=0;
+      row[0]=f;
+      for(let x=0;x<stride;x++){
+        const v=px[y*stride+x],a=x>=4?px[y*stride+x-4]:0,b=y?px[(y-1)*stride+x]:0,c=x>=4&&y?px[(y-1)*stride+x-4]:0;
+        const r=(v-(f===1?a:f===2?b:f===3?(a+b)>>1:f===4?paeth(a,b,c):0))&255;
+        row[x+1]=r; sum+=r<128?r:256-r;
+      }
+      if(sum<bestSum){best=row; bestSum=sum;}
+    }
+    best.copy(raw,y*(stride+1));
+  }
+  const chunk=(type,data)=>{
+    const b=Buffer.alloc(12+data.length);
+    b.writeUInt32BE(data.length,0); b.write(type,4,'latin1'); data.copy(b,8);
+    b.writeUInt32BE(crc32(b.subarray(4,8+data.length)),8+data.length);
+    return b;
+  };
+  const ihdr=Buffer.alloc(13);
+  ihdr.writeUInt32BE(w,0); ihdr.writeUInt32BE(h,4); ihdr[8]=8; ihdr[9]=6;
+  return Buffer.concat([Buffer.from([137,80,78,71,13,10,26,10]),chunk('IHDR',ihdr),
+    chunk('IDAT',zlib.deflateSync(raw,{level:9})),chunk('IEND',Buffer.alloc(0))]);
+}
+// box filter in premultiplied alpha, so transparent edges do not darken
+function downscale({w,h,px},size){
+  const s=size/Math.max(w,h),dw=Math.round(w*s),dh=Math.round(h*s),dst=new Uint8Array(dw*dh*4);
+  for(let y=0;y<dh;y++) for(let x=0;x<dw;x++){
+    const x0=Math.floor(x*w/dw),x1=Math.floor((x+1)*w/dw),y0=Math.floor(y*h/dh),y1=Math.floor((y+1)*h/dh);
+    let r=0,g=0,b=0,a=0;
+    for(let sy=y0;sy<y1;sy++) for(let sx=x0;sx<x1;sx++){
+      const o=(sy*w+sx)*4,al=px[o+3];
+      r+=px[o]*al; g+=px[o+1]*al; b+=px[o+2]*al; a+=al;
+    }
+    const d=(y*dw+x)*4,n=(x1-x0)*(y1-y0);
+    if(a){dst[d]=Math.round(r/a); dst[d+1]=Math.round(g/a); dst[d+2]=Math.round(b/a);}
+    dst[d+3]=Math.round(a/n);
+  }
+  return {w:dw,h:dh,px:dst};
+}
+
+module.exports={decodePng,encodePng,downscale};
@@ -0,0 +1,103 @@
+// Stall watchdog for the frame loop (see the watchdog in game.js).
+//
+// The page starts it with {type:'start', stallMs, frames, fields} plus either
+// a SharedArrayBuffer ring ({shared}) or a MessagePort ({port}). Every frame
+// the page publishes one record of fields.length numbers describing it:
+//   shared  Int32 frame count in the first 8 bytes, then `frames` Float64
+//           records as a ring, the count stored after the record is written
+//   port    the record itself as a Float64Array, copied into a ring here
+// This thread keeps running while the page is frozen, so when no frame
+// arrives for stallMs it saves the last `frames` records to the crash ring
+// in IndexedDB right away (localStorage is not reachable from a worker),
+// keeping CRASH_RING entries, and fills in the stall's length once frames
+// resume. {type:'pause'} and {type:'resume'} bracket times the page stops
+// ticking on purpose (hidden tab, no instances left), which are not
+// stalls. {type:'crashes'} replies with the saved entries, oldest first;
+// {type:'clear'} empties the ring.
+const CHECK_MS=50,CRASH_RING=20,DB='maf-watchdog',STORE='stalls';
+
+let cfg=null,ring=null,count=null,seen=0,lastFrameAt=0,stall=null,paused=false;
+
+onmessage=e=>{
+  const m=e.data;
+  if(m.type==='start'&&!cfg){
+    cfg=m; lastFrameAt=performance.now();
+    if(m.shared){
+      count=new Int32Array(m.shared,0,2); ring=new Float64Array(m.shared,8);
+    }else{
+      ring=new Float64Array(m.frames*m.fields.length);
+      m.port.onmessage=e=>{
+        ring.set(e.data,(seen%cfg.frames)*cfg.fields.length);
+        seen++; resumed();
+      };
+    }
+    setInterval(check,CHECK_MS);
+  }else if(m.type==='pause'){
+    if(stall) resumed();
+    paused=true;
+  }else if(m.type==='resume'){
+    paused=false; lastFrameAt=performance.now();
+  }else if(m.type==='crashes'){
+    withStore('readonly',s=>{s.getAll().onsuccess=e=>postMessage({type:'crashes',list:e.target.result});});
+  }else if(m.type==='clear') withStore('readwrite',s=>s.clear());
+};
+
+function check(){
+  if(!cfg||paused) return;
+  if(count){
+    const n=Atomics.load(count,0);
+    if(n!==seen){seen=n; resumed();}
+  }
+  if(!stall&&seen&&performance.now()-lastFrameAt>cfg.stallMs) save();
+}
+function resumed(){
+  const now=performance.now();
+  if(stall){
+    stall.stalledMs=Math.round(now-lastFrameAt);
+    const entry=stall;
+    withStore('readwrite',s=>s.put(entry,entry.at));
+    stall=null;
+  }
+  lastFrameAt=now;
+}
+
+// the last frames before the stall, oldest first, as {field: value} objects
+function snapshot(){
+  const F=cfg.fields.length,frames=[];
+  for(let k=Math.max(0,seen-cfg.frames);k<seen;k++){
+    const o=(k%cfg.frames)*F,f={};
+    cfg.fields.forEach((name,j)=>{f[name]=ring[o+j];});
+    frames.push(f);
+  }
+  return frames;
+}
+function save(){
+  const entry=stall={at:Date.now(),stallMs:cfg.stallMs,stalledMs:null,frame:seen,
+    frames:snapshot(),userAgent:navigator.userAgent};
+  withStore('readwrite',s=>{
+    s.put(entry,entry.at);
+    s.getAllKeys().onsuccess=e=>{
+      const keys=e.target.result;
+      for(let i=0;i<keys.length-CRASH_RING;i++) s.delete(keys[i]);
+    };
+  });
+}
+
+// entries are keyed by detection time, so key order is age order
+let db=null;
+const waiting=[];
+function withStore(mode,fn){
+  if(db) return fn(db.transaction(STORE,mode).objectStore(STORE));
+  waiting.push([mode,fn]);
+  if(waiting.length>1) return;
+  const req=indexedDB.open(DB,1);
+  req.onupgradeneeded=()=>req.result.createObjectStore(STORE);
+  req.onsuccess=()=>{
+    db=req.result;
+    waiting.splice(0).forEach(([mode,fn])=>withStore(mode,fn));
+  };
+  req.onerror=()=>{
+    console.warn('watchdog: no IndexedDB, stalls are not kept');
+    waiting.length=0;
+  };
+}